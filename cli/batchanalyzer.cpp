@@ -0,0 +1,248 @@
+#include "batchanalyzer.h"
+#include "wavanalysisjob.h"
+#include "gme/gme.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+#include <algorithm>
+
+// Analysis never listens to the emulators, so their sample rate hardly matters.
+const int SAMPLE_RATE = 44100;
+const int MAX_TRACKS = 256;
+
+static QString csv_field(QString field) {
+    return "\"" + field.replace("\"", "\"\"") + "\"";
+}
+
+BatchAnalyzer::BatchAnalyzer(QDir input_dir, QDir output_dir, Format format, int thread_count, QObject *parent)
+    : QObject(parent), input_dir(input_dir), output_dir(output_dir), format(format),
+      cancelled(QSharedPointer<QAtomicInt>::create(0))
+{
+    qRegisterMetaType<TrackAnalysis>("TrackAnalysis");
+    this->pool.setMaxThreadCount(thread_count);
+}
+
+BatchAnalyzer::~BatchAnalyzer() {
+    this->cancelled->storeRelease(1);
+    this->pool.waitForDone();
+}
+
+void BatchAnalyzer::start(QStringList file_names) {
+    this->batch_timer.start();
+    this->output_dir.mkpath(".");
+    this->timing_file.setFileName(this->output_dir.filePath("timing.csv"));
+    if (!this->timing_file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << this->timing_file.fileName() << this->timing_file.errorString();
+    }
+    this->timing_file.write("file,tracks,tones,audio_sec,analysis_msec,error\n");
+    this->files.resize(file_names.size());
+    this->file_remain = file_names.size();
+    if (!this->file_remain) {
+        this->timing_file.close();
+        emit this->finished(0);
+        return;
+    }
+    for (int file_i = 0; file_i < file_names.size(); file_i += 1) {
+        FileAnalysis &file = this->files[file_i];
+        file.file_name = file_names[file_i];
+        QString lower_name = file.file_name.toLower();
+        if (lower_name.endsWith(".nsf") || lower_name.endsWith(".nsfe")) {
+            this->start_nsf(file_i);
+        } else {
+            file.track_remain = 1;
+            WavAnalysisJob *job = new WavAnalysisJob { quint64(file_i), file.file_name };
+            this->submit(job, job);
+        }
+    }
+}
+
+// Every track gets its own job, so the tracks of one file are analysed in parallel too.
+void BatchAnalyzer::start_nsf(quint64 file_i) {
+    FileAnalysis &file = this->files[file_i];
+    QFile in(file.file_name);
+    if (!in.open(QIODevice::ReadOnly)) {
+        file.errors.append(in.errorString());
+        this->file_done(file_i);
+        return;
+    }
+    QByteArray file_data = in.readAll();
+    Music_Emu *emu { nullptr };
+    gme_err_t err = gme_open_data(file_data.constData(), file_data.size(), &emu, SAMPLE_RATE);
+    if (err) {
+        file.errors.append(err);
+        this->file_done(file_i);
+        return;
+    }
+    int track_count = std::min(gme_track_count(emu), MAX_TRACKS);
+    file.track_remain = track_count;
+    bool streaming = false;
+    for (int track_num = 0; track_num < track_count; track_num += 1) {
+        gme_info_t *track_info;
+        if (gme_track_info(emu, &track_info, track_num)) {
+            file.track_remain -= 1;
+            continue;
+        }
+        qreal length_sec = track_info->play_length / 1000.0;
+        gme_free_info(track_info);
+        AnalysisJob *job = new AnalysisJob { file_i, this->cancelled, file_data, SAMPLE_RATE,
+                                             qint16(track_num), length_sec, streaming };
+        this->submit(job, job);
+    }
+    gme_delete(emu);
+    if (!file.track_remain) {
+        this->file_done(file_i);
+    }
+}
+
+void BatchAnalyzer::submit(QObject *job, QRunnable *runnable) {
+    QObject::connect(job, SIGNAL(finished(quint64, TrackAnalysis)),
+                     this, SLOT(handleFinished(quint64, TrackAnalysis)));
+    QObject::connect(job, SIGNAL(failed(quint64, QString)),
+                     this, SLOT(handleFailed(quint64, QString)));
+    this->pool.start(runnable);
+}
+
+void BatchAnalyzer::handleFinished(quint64 job_id, TrackAnalysis analysis) {
+    // Only the tones are kept. The emulator was restarted for playback nobody here wants.
+    gme_delete(analysis.emu);
+    analysis.emu = nullptr;
+    this->files[job_id].tracks.append(analysis);
+    this->track_done(job_id);
+}
+
+void BatchAnalyzer::handleFailed(quint64 job_id, QString error) {
+    this->files[job_id].errors.append(error);
+    this->track_done(job_id);
+}
+
+void BatchAnalyzer::track_done(quint64 file_i) {
+    FileAnalysis &file = this->files[file_i];
+    file.track_remain -= 1;
+    if (!file.track_remain) {
+        this->file_done(file_i);
+    }
+}
+
+void BatchAnalyzer::file_done(quint64 file_i) {
+    FileAnalysis &file = this->files[file_i];
+    std::sort(file.tracks.begin(), file.tracks.end(), [](const TrackAnalysis &a, const TrackAnalysis &b) {
+        return a.track_num < b.track_num;
+    });
+    if (!file.tracks.isEmpty()) {
+        QString error = this->write_tones(file);
+        if (!error.isEmpty()) {
+            file.errors.append(error);
+        }
+    }
+    if (!file.errors.isEmpty()) {
+        this->failed_count += 1;
+    }
+    this->write_timing(file);
+    // Written out, so there's no need to hold on to the tones.
+    file.tracks.clear();
+    this->file_remain -= 1;
+    if (!this->file_remain) {
+        this->timing_file.close();
+        QTextStream(stdout) << "Analysed " << this->files.size() << " files in "
+                            << this->batch_timer.elapsed() << " ms, " << this->failed_count << " failed\n";
+        emit this->finished(this->failed_count);
+    }
+}
+
+// Returns an error message, or an empty string once the file is written.
+QString BatchAnalyzer::write_tones(const FileAnalysis &file) {
+    QString out_name = this->output_dir.filePath(this->input_dir.relativeFilePath(file.file_name)
+                                                 + (this->format == Json ? ".tones.json" : ".tones.csv"));
+    QDir().mkpath(QFileInfo(out_name).path());
+    QFile out(out_name);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return out_name + ": " + out.errorString();
+    }
+    if (this->format == Json) {
+        this->write_json(out, file);
+    } else {
+        this->write_csv(out, file);
+    }
+    return QString();
+}
+
+void BatchAnalyzer::write_json(QFile &out, const FileAnalysis &file) const {
+    QJsonArray tracks;
+    for (const TrackAnalysis &track: file.tracks) {
+        QJsonArray channels;
+        for (const QVector<ToneObject> &channel_tones: track.tones) {
+            QJsonArray tones;
+            for (const ToneObject &tone: channel_tones) {
+                tones.append(QJsonObject {
+                    { "start", qint64(tone.start) },
+                    { "length", qint64(tone.length) },
+                    { "semitone_id", tone.semitone_id },
+                    { "name", semitone_name(tone.semitone_id) },
+                    { "nes_timer", tone.nes_timer },
+                    { "nes_timer_end", tone.nes_timer_end },
+                    { "shape", tone.shape },
+                    { "volume", tone.volume }
+                });
+            }
+            channels.append(tones);
+        }
+        tracks.append(QJsonObject {
+            { "track", track.track_num + 1 },
+            { "length_sec", track.length_sec },
+            { "analysis_msec", track.analysis_msec },
+            { "channels", channels }
+        });
+    }
+    QJsonObject root {
+        { "file", this->input_dir.relativeFilePath(file.file_name) },
+        // Tone starts and lengths are in CPU cycles.
+        { "clock_rate", CPU_FREQENCY },
+        { "tracks", tracks }
+    };
+    out.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+}
+
+void BatchAnalyzer::write_csv(QFile &out, const FileAnalysis &file) const {
+    QTextStream stream(&out);
+    stream << "track,channel,start,length,semitone_id,name,nes_timer,nes_timer_end,shape,volume\n";
+    for (const TrackAnalysis &track: file.tracks) {
+        for (int channel_i = 0; channel_i < 3; channel_i += 1) {
+            for (const ToneObject &tone: track.tones[channel_i]) {
+                stream << track.track_num + 1 << ',' << channel_i << ',' << qint64(tone.start) << ','
+                       << qint64(tone.length) << ',' << tone.semitone_id << ',' << semitone_name(tone.semitone_id) << ','
+                       << tone.nes_timer << ',' << tone.nes_timer_end << ',' << tone.shape << ','
+                       << int(tone.volume) << '\n';
+            }
+        }
+    }
+}
+
+void BatchAnalyzer::write_timing(const FileAnalysis &file) {
+    int tone_count = 0;
+    qreal audio_sec = 0;
+    qint64 analysis_msec = 0;
+    for (const TrackAnalysis &track: file.tracks) {
+        for (const QVector<ToneObject> &tones: track.tones) {
+            tone_count += tones.size();
+        }
+        audio_sec += track.length_sec;
+        analysis_msec += track.analysis_msec;
+    }
+    QString relative_name = this->input_dir.relativeFilePath(file.file_name);
+    QString error = file.errors.join("; ");
+    QTextStream timing(&this->timing_file);
+    timing << csv_field(relative_name) << ',' << file.tracks.size() << ',' << tone_count << ','
+           << audio_sec << ',' << analysis_msec << ',' << csv_field(error) << '\n';
+    QTextStream out(stdout);
+    out << relative_name << ": " << file.tracks.size() << " tracks, " << tone_count << " tones in "
+        << analysis_msec << " ms";
+    if (!error.isEmpty()) {
+        out << " (" << error << ")";
+    }
+    out << '\n';
+}
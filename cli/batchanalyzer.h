@@ -0,0 +1,73 @@
+#ifndef BATCHANALYZER_H
+#define BATCHANALYZER_H
+
+#include <QAtomicInt>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QObject>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+#include "analysisjob.h"
+
+// Analyses every track of a batch of NSF, NSFe and APU capture files on a
+// thread pool. As each file is done, its tones are written under the output
+// directory, at the file's path relative to the input directory, and a line
+// saying how long it took is added to timing.csv there.
+class BatchAnalyzer : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Format {
+        Json,
+        Csv
+    };
+
+    BatchAnalyzer(QDir input_dir, QDir output_dir, Format format, int thread_count, QObject *parent = nullptr);
+    ~BatchAnalyzer();
+
+public slots:
+    // Emits finished() once every file is done.
+    void start(QStringList file_names);
+
+signals:
+    void finished(int failed_count);
+
+private slots:
+    void handleFinished(quint64 job_id, TrackAnalysis analysis);
+    void handleFailed(quint64 job_id, QString error);
+
+private:
+    struct FileAnalysis {
+        QString file_name;
+        int track_remain = 0;
+        QVector<TrackAnalysis> tracks;
+        QStringList errors;
+    };
+
+    void start_nsf(quint64 file_i);
+    void submit(QObject *job, QRunnable *runnable);
+    void track_done(quint64 file_i);
+    void file_done(quint64 file_i);
+    QString write_tones(const FileAnalysis &file);
+    void write_json(QFile &out, const FileAnalysis &file) const;
+    void write_csv(QFile &out, const FileAnalysis &file) const;
+    void write_timing(const FileAnalysis &file);
+
+    const QDir input_dir;
+    const QDir output_dir;
+    const Format format;
+    QThreadPool pool;
+    QSharedPointer<QAtomicInt> cancelled;
+    QVector<FileAnalysis> files;
+    int file_remain = 0;
+    int failed_count = 0;
+    QFile timing_file;
+    QElapsedTimer batch_timer;
+};
+
+#endif // BATCHANALYZER_H
@@ -0,0 +1,51 @@
+TEMPLATE = app
+TARGET = nestoration-cli
+
+QT -= gui
+
+CONFIG += c++11
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += $$PWD/../libgme
+INCLUDEPATH += $$PWD/../src
+
+# The analysis core is shared with the app, without anything that needs a GUI.
+SOURCES += \
+        ../src/analysisjob.cpp \
+        ../src/archiveblockreader.cpp \
+        ../src/miniapu.cpp \
+        ../src/runbuffer.cpp \
+        ../src/runscanner.cpp \
+        ../src/squarechannel.cpp \
+        ../src/toneextractor.cpp \
+        ../src/toneobject.cpp \
+        ../src/trianglechannel.cpp \
+        ../src/wavanalysis.cpp \
+        batchanalyzer.cpp \
+        main.cpp \
+        wavanalysisjob.cpp
+
+HEADERS += \
+    ../src/analysisjob.h \
+    ../src/archiveblockreader.h \
+    ../src/miniapu.h \
+    ../src/runbuffer.h \
+    ../src/runscanner.h \
+    ../src/squarechannel.h \
+    ../src/toneextractor.h \
+    ../src/toneobject.h \
+    ../src/trianglechannel.h \
+    ../src/wavanalysis.h \
+    batchanalyzer.h \
+    wavanalysisjob.h
+
+unix:!android: target.path = /opt/nestoration/bin
+!isEmpty(target.path): INSTALLS += target
+
+unix: LIBS += -larchive
+macx: LIBS += -larchive
+
+LIBS += -L$$OUT_PWD/../libgme -lgme
@@ -0,0 +1,72 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+
+#include "batchanalyzer.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setOrganizationName("Nestoration");
+    app.setOrganizationDomain("Nestoration.com");
+    app.setApplicationName("nestoration-cli");
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Finds the tones in every NSF, NSFe and APU capture in a directory.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("directory", "The directory of files to analyse.");
+    QCommandLineOption threads_option({ "j", "threads" }, "Analyse this many tracks at once.", "count",
+                                      QString::number(QThread::idealThreadCount()));
+    QCommandLineOption format_option({ "f", "format" }, "Write tones as json or csv.", "format", "json");
+    QCommandLineOption output_option({ "o", "output" }, "Write results here instead of next to the files.", "directory");
+    QCommandLineOption recursive_option({ "r", "recursive" }, "Analyse the files in subdirectories too.");
+    parser.addOption(threads_option);
+    parser.addOption(format_option);
+    parser.addOption(output_option);
+    parser.addOption(recursive_option);
+    parser.process(app);
+
+    QTextStream err(stderr);
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(2);
+    }
+    QDir input_dir(parser.positionalArguments()[0]);
+    if (!input_dir.exists()) {
+        err << input_dir.path() << ": no such directory\n";
+        return 2;
+    }
+    bool threads_ok;
+    int thread_count = parser.value(threads_option).toInt(&threads_ok);
+    if (!threads_ok || thread_count < 1) {
+        err << "The thread count must be a positive number\n";
+        return 2;
+    }
+    QString format_name = parser.value(format_option).toLower();
+    if (format_name != "json" && format_name != "csv") {
+        err << "The format must be json or csv\n";
+        return 2;
+    }
+    BatchAnalyzer::Format format = format_name == "json" ? BatchAnalyzer::Json : BatchAnalyzer::Csv;
+    QDir output_dir = parser.isSet(output_option) ? QDir(parser.value(output_option)) : input_dir;
+
+    QStringList file_names;
+    QDirIterator files(input_dir.path(), { "*.nsf", "*.nsfe", "*.wav", "*.wav.gz", "*.wav.xz" }, QDir::Files,
+                       parser.isSet(recursive_option) ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+    while (files.hasNext()) {
+        file_names.append(files.next());
+    }
+    file_names.sort();
+
+    BatchAnalyzer analyzer { input_dir, output_dir, format, thread_count };
+    QObject::connect(&analyzer, &BatchAnalyzer::finished, &app, [](int failed_count) {
+        QCoreApplication::exit(failed_count ? 1 : 0);
+    }, Qt::QueuedConnection);
+    // Started from the event loop, so finishing right away still ends it.
+    QTimer::singleShot(0, &analyzer, [&analyzer, file_names]() {
+        analyzer.start(file_names);
+    });
+    return app.exec();
+}
@@ -0,0 +1,32 @@
+#include "wavanalysisjob.h"
+#include "wavanalysis.h"
+
+#include <QElapsedTimer>
+
+WavAnalysisJob::WavAnalysisJob(quint64 job_id, QString file_name)
+    : job_id(job_id), file_name(file_name)
+{
+    // The job deletes itself with deleteLater() once its signals have been sent.
+    this->setAutoDelete(false);
+}
+
+void WavAnalysisJob::run() {
+    QElapsedTimer timer;
+    timer.start();
+    WavAnalysis wav;
+    QString error = wav.analyse(this->file_name);
+    if (!error.isEmpty()) {
+        emit this->failed(this->job_id, error);
+        this->deleteLater();
+        return;
+    }
+    TrackAnalysis analysis;
+    analysis.track_num = 0;
+    analysis.length_sec = wav.channel_runs[0].sample_length() / CPU_FREQENCY;
+    for (int channel_i = 0; channel_i < 3; channel_i += 1) {
+        analysis.tones[channel_i] = wav.tones[channel_i];
+    }
+    analysis.analysis_msec = timer.elapsed();
+    emit this->finished(this->job_id, analysis);
+    this->deleteLater();
+}
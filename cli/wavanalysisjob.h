@@ -0,0 +1,30 @@
+#ifndef WAVANALYSISJOB_H
+#define WAVANALYSISJOB_H
+
+#include <QObject>
+#include <QRunnable>
+#include <QString>
+
+#include "analysisjob.h"
+
+// Finds the tones in one APU capture on a thread pool, and reports them the
+// same way an AnalysisJob reports a track, as track 0 without an emulator.
+class WavAnalysisJob : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    WavAnalysisJob(quint64 job_id, QString file_name);
+
+    void run() override;
+
+signals:
+    void finished(quint64 job_id, TrackAnalysis analysis);
+    void failed(quint64 job_id, QString error);
+
+private:
+    const quint64 job_id;
+    const QString file_name;
+};
+
+#endif // WAVANALYSISJOB_H
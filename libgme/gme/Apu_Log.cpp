@@ -0,0 +1,69 @@
+#include "Apu_Log.h"
+
+/* This module is free software; you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. This module is distributed in the hope that it
+will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser
+General Public License for more details. You should have received a copy of
+the GNU Lesser General Public License along with this module; if not, write
+to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+Boston, MA 02110-1301 USA */
+
+#include "blargg_source.h"
+
+Apu_Log::Apu_Log()
+{
+	chunk_count = 0;
+	size_       = 0;
+}
+
+Apu_Log::~Apu_Log() { clear(); }
+
+void Apu_Log::clear( bool free_memory )
+{
+	size_ = 0;
+	if ( !free_memory )
+		return;
+	
+	for ( long i = 0; i < chunk_count; i++ )
+		free( chunks [i] );
+	chunks.clear();
+	chunk_count = 0;
+}
+
+blargg_err_t Apu_Log::grow( long chunks_needed )
+{
+	if ( chunks_needed > (long) chunks.size() )
+	{
+		// grow the chunk table geometrically; the chunks themselves never move
+		long table_size = chunks.size() * 2;
+		if ( table_size < chunks_needed )
+			table_size = chunks_needed;
+		RETURN_ERR( chunks.resize( table_size ) );
+	}
+	while ( chunk_count < chunks_needed )
+	{
+		chunk_t* c = (chunk_t*) malloc( sizeof (chunk_t) );
+		CHECK_ALLOC( c );
+		chunks [chunk_count++] = c;
+	}
+	return 0;
+}
+
+blargg_err_t Apu_Log::reserve( long count )
+{
+	return grow( (count + chunk_size - 1) >> chunk_bits );
+}
+
+apu_log_t Apu_Log::at( long i ) const
+{
+	chunk_t const& c = chunk( i );
+	i &= chunk_mask;
+	apu_log_t entry( c.cpu_cycle [i], (apu_log_event) c.event [i] );
+	entry.address = c.address [i];
+	entry.data    = c.data    [i];
+	entry.channel = c.channel [i];
+	return entry;
+}
@@ -0,0 +1,110 @@
+// Append-only log of NES APU events, stored column-wise in fixed-size chunks
+
+#ifndef APU_LOG_H
+#define APU_LOG_H
+
+#include "blargg_common.h"
+
+enum apu_log_event {
+	register_write,
+	timeout,
+	timeout_linear,
+	reloaded_linear,
+	sweep
+};
+
+struct apu_log_t {
+	apu_log_t (long long cpu_cycle, apu_log_event event) : cpu_cycle(cpu_cycle), event(event) {};
+	bool operator<(const apu_log_t &other) const {
+		return this->cpu_cycle < other.cpu_cycle;
+	}
+	long long cpu_cycle;
+	apu_log_event event;
+	unsigned address = 0;
+	short data = 0;
+	char channel = 0;
+};
+
+// Entries are appended in order of non-decreasing CPU cycle, so the log is
+// always sorted and can be read back sequentially without a sort pass.
+class Apu_Log {
+public:
+	// Add an entry. If memory runs out the entry is dropped.
+	void append( long long cpu_cycle, apu_log_event, unsigned address = 0,
+			int data = 0, int channel = 0 );
+
+	// Allocate room for at least 'count' entries up front
+	blargg_err_t reserve( long count );
+
+	// Remove all entries. Memory is kept for reuse unless 'free_memory' is true.
+	void clear( bool free_memory = true );
+
+	long size() const                               { return size_; }
+	bool empty() const                              { return !size_; }
+
+	// Columns of entry i
+	long long cpu_cycle( long i ) const             { return chunk( i ).cpu_cycle [i & chunk_mask]; }
+	apu_log_event event( long i ) const             { return (apu_log_event) chunk( i ).event [i & chunk_mask]; }
+	unsigned address( long i ) const                { return chunk( i ).address [i & chunk_mask]; }
+	short data( long i ) const                      { return chunk( i ).data [i & chunk_mask]; }
+	char channel( long i ) const                    { return chunk( i ).channel [i & chunk_mask]; }
+
+	// Entry i as a single struct
+	apu_log_t at( long i ) const;
+
+	class const_iterator {
+	public:
+		const_iterator( Apu_Log const* log, long i ) : log( log ), i( i ) { }
+		apu_log_t operator * () const               { return log->at( i ); }
+		const_iterator& operator ++ ()              { ++i; return *this; }
+		bool operator != ( const_iterator const& other ) const { return i != other.i; }
+	private:
+		Apu_Log const* log;
+		long i;
+	};
+	const_iterator begin() const                    { return const_iterator( this, 0 ); }
+	const_iterator end() const                      { return const_iterator( this, size_ ); }
+
+public:
+	Apu_Log();
+	~Apu_Log();
+private:
+	// noncopyable
+	Apu_Log( const Apu_Log& );
+	Apu_Log& operator = ( const Apu_Log& );
+
+	enum { chunk_bits = 12 };
+	enum { chunk_size = 1 << chunk_bits };
+	enum { chunk_mask = chunk_size - 1 };
+	struct chunk_t {
+		long long cpu_cycle [chunk_size];
+		uint16_t address [chunk_size];
+		int16_t data [chunk_size];
+		uint8_t event [chunk_size];
+		int8_t channel [chunk_size];
+	};
+	blargg_vector<chunk_t*> chunks;
+	long chunk_count; // chunks allocated
+	long size_;
+
+	chunk_t const& chunk( long i ) const            { return *chunks [i >> chunk_bits]; }
+	blargg_err_t grow( long chunks_needed );
+};
+
+inline void Apu_Log::append( long long cpu_cycle, apu_log_event event, unsigned address,
+		int data, int channel )
+{
+	long i = size_;
+	if ( (i >> chunk_bits) >= chunk_count && grow( (i >> chunk_bits) + 1 ) )
+		return;
+	chunk_t& c = *chunks [i >> chunk_bits];
+	i &= chunk_mask;
+	c.cpu_cycle [i] = cpu_cycle;
+	c.address   [i] = (uint16_t) address;
+	c.data      [i] = (int16_t) data;
+	c.event     [i] = (uint8_t) event;
+	c.channel   [i] = (int8_t) channel;
+	size_++;
+}
+
+#endif
@@ -20,9 +20,11 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA */
 
 Classic_Emu::Classic_Emu()
 {
-	buf           = 0;
-	stereo_buffer = 0;
-	voice_types   = 0;
+	buf            = 0;
+	stereo_buffer  = 0;
+	voice_types    = 0;
+	samples_played = 0;
+	analyze_offset = 0;
 	
 	// avoid inconsistency in our duplicated constants
 	assert( (int) wave_type  == (int) Multi_Buffer::wave_type );
@@ -98,9 +100,18 @@ blargg_err_t Classic_Emu::start_track_( int track )
 {
 	RETURN_ERR( Music_Emu::start_track_( track ) );
 	buf->clear();
+	samples_played = 0;
+	analyze_offset = 0;
 	return 0;
 }
 
+void Classic_Emu::keyframe_restored( long pos )
+{
+	buf->clear();
+	samples_played = pos;
+	analyze_offset = 0;
+}
+
 blargg_err_t Classic_Emu::play_( long count, sample_t* out )
 {
 	long remain = count;
@@ -114,6 +125,7 @@ blargg_err_t Classic_Emu::play_( long count, sample_t* out )
 				buf_changed_count = buf->channels_changed_count();
 				remute_voices();
 			}
+			save_keyframe_( samples_played + count - remain );
 			int msec = buf->length();
 			blip_time_t clocks_emulated = (blargg_long) msec * clock_rate_ / 1000;
 			RETURN_ERR( run_clocks( clocks_emulated, msec ) );
@@ -121,9 +133,47 @@ blargg_err_t Classic_Emu::play_( long count, sample_t* out )
 			buf->end_frame( clocks_emulated );
 		}
 	}
+	samples_played += count;
 	return 0;
 }
 
+blargg_err_t Classic_Emu::analyze( long count )
+{
+	require( current_track() >= 0 );
+	
+	// oscillators without an output only keep their timing up to date
+	for ( int i = voice_count(); i--; )
+		set_voice( i, 0, 0, 0 );
+	
+	// Advance position exactly as the buffer would, so keyframes saved here
+	// line up with those play() would have saved
+	Blip_Buffer const* timing = buf->channel( 0, (voice_types ? voice_types [0] : 0) ).center;
+	long const end = samples_played + count;
+	long pos = samples_played + buf->samples_avail();
+	blip_resampled_time_t offset = analyze_offset;
+	blargg_err_t err = 0;
+	while ( pos < end )
+	{
+		save_keyframe_( pos );
+		int msec = buf->length();
+		blip_time_t clocks_emulated = (blargg_long) msec * clock_rate_ / 1000;
+		err = run_clocks( clocks_emulated, msec );
+		if ( err )
+			break;
+		assert( clocks_emulated );
+		offset += timing->resampled_duration( clocks_emulated );
+		pos += (long) (offset >> BLIP_BUFFER_ACCURACY) * buf->samples_per_frame();
+		offset &= ((blip_resampled_time_t) 1 << BLIP_BUFFER_ACCURACY) - 1;
+	}
+	
+	// consecutive calls continue where this one stopped
+	buf->clear();
+	samples_played = pos;
+	analyze_offset = offset;
+	remute_voices();
+	return err;
+}
+
 // Rom_Data
 
 blargg_err_t Rom_Data_::load_rom_data_( Data_Reader& in,
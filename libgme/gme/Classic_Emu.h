@@ -14,6 +14,13 @@ public:
 	~Classic_Emu();
 	void set_buffer( Multi_Buffer* );
 	blargg_err_t set_multi_channel( bool is_enabled ) override;
+	
+	// Run current track for 'count' samples without synthesizing any sound.
+	// Voices are disconnected and nothing is read from the buffer, so only the
+	// emulator's side effects (register logging, keyframes) are produced, many
+	// times faster than play(). Afterwards the track must be restarted with
+	// start_track() before it is played.
+	blargg_err_t analyze( long count );
 protected:
 	// Services
 	enum { wave_type = 0x100, noise_type = 0x200, mixed_type = wave_type | noise_type };
@@ -28,6 +35,15 @@ protected:
 	virtual void update_eq( blip_eq_t const& ) = 0;
 	virtual blargg_err_t start_track_( int track ) = 0;
 	virtual blargg_err_t run_clocks( blip_time_t& time_io, int msec ) = 0;
+	
+	// Called between frames once all buffered output has been read, with the
+	// number of samples played since start_track_(). Emulators that support
+	// keyframes may save a snapshot of their state for that position here.
+	virtual void save_keyframe_( long /* pos */ ) { }
+	
+	// Must be called by restore_keyframe_() after restoring a snapshot saved
+	// at 'pos', to discard buffered output and resume counting from there.
+	void keyframe_restored( long pos );
 protected:
 	blargg_err_t set_sample_rate_( long sample_rate );
 	void mute_voices_( int );
@@ -37,6 +53,8 @@ private:
 	Multi_Buffer* buf;
 	Multi_Buffer* stereo_buffer; // NULL if using custom buffer
 	long clock_rate_;
+	long samples_played; // since start_track_()
+	blip_resampled_time_t analyze_offset; // fraction of a sample carried between analyze() calls
 	unsigned buf_changed_count;
 	int const* voice_types;
 };
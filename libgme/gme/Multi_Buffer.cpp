@@ -230,3 +230,83 @@ void Stereo_Buffer::mix_mono( blip_sample_t* out_, blargg_long count )
 	
 	BLIP_READER_END( center, bufs [0] );
 }
+
+// Voice_Buffer
+
+Voice_Buffer::Voice_Buffer() : Multi_Buffer( voice_count * 2 ) { }
+
+Voice_Buffer::~Voice_Buffer() { }
+
+blargg_err_t Voice_Buffer::set_sample_rate( long rate, int msec )
+{
+	for ( int i = 0; i < voice_count; i++ )
+		RETURN_ERR( bufs [i].set_sample_rate( rate, msec ) );
+	return Multi_Buffer::set_sample_rate( bufs [0].sample_rate(), bufs [0].length() );
+}
+
+void Voice_Buffer::clock_rate( long rate )
+{
+	for ( int i = 0; i < voice_count; i++ )
+		bufs [i].clock_rate( rate );
+}
+
+void Voice_Buffer::bass_freq( int bass )
+{
+	for ( int i = 0; i < voice_count; i++ )
+		bufs [i].bass_freq( bass );
+}
+
+void Voice_Buffer::clear()
+{
+	for ( int i = 0; i < voice_count; i++ )
+		bufs [i].clear();
+}
+
+Multi_Buffer::channel_t Voice_Buffer::channel( int index, int )
+{
+	Blip_Buffer* buf = &bufs [index < voice_count ? index : voice_count - 1];
+	channel_t chan;
+	chan.center = buf;
+	chan.left   = buf;
+	chan.right  = buf;
+	return chan;
+}
+
+void Voice_Buffer::end_frame( blip_time_t clock_count )
+{
+	for ( int i = 0; i < voice_count; i++ )
+		bufs [i].end_frame( clock_count );
+}
+
+long Voice_Buffer::read_samples( blip_sample_t* out, long count )
+{
+	int const frame_size = voice_count * 2;
+	require( count % frame_size == 0 );
+	count /= frame_size;
+	
+	long avail = bufs [0].samples_avail();
+	if ( count > avail )
+		count = avail;
+	
+	for ( int i = 0; i < voice_count; i++ )
+	{
+		// each voice is mono, so both sides of its pair are the same
+		blip_sample_t* BLIP_RESTRICT voice_out = out + i * 2;
+		int const bass = BLIP_READER_BASS( bufs [i] );
+		BLIP_READER_BEGIN( voice, bufs [i] );
+		for ( long n = count; n; --n )
+		{
+			blargg_long s = BLIP_READER_READ( voice );
+			if ( (int16_t) s != s )
+				s = 0x7FFF - (s >> 24);
+			BLIP_READER_NEXT( voice, bass );
+			voice_out [0] = s;
+			voice_out [1] = s;
+			voice_out += frame_size;
+		}
+		BLIP_READER_END( voice, bufs [i] );
+		bufs [i].remove_samples( count );
+	}
+	
+	return count * frame_size;
+}
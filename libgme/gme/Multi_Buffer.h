@@ -121,6 +121,29 @@ private:
 	void mix_mono( blip_sample_t*, blargg_long );
 };
 
+// Uses one buffer per voice and outputs a stereo pair for each, voice_count
+// pairs to a frame, so voices can be mixed after they're rendered. Voices past
+// the last share its buffer.
+class Voice_Buffer : public Multi_Buffer {
+public:
+	enum { voice_count = 8 };
+	
+	Voice_Buffer();
+	~Voice_Buffer();
+	blargg_err_t set_sample_rate( long, int msec = blip_default_length );
+	void clock_rate( long );
+	void bass_freq( int );
+	void clear();
+	channel_t channel( int index, int );
+	void end_frame( blip_time_t );
+	
+	long samples_avail() const { return bufs [0].samples_avail() * (voice_count * 2); }
+	long read_samples( blip_sample_t*, long );
+	
+private:
+	Blip_Buffer bufs [voice_count];
+};
+
 // Silent_Buffer generates no samples, useful where no sound is wanted
 class Silent_Buffer : public Multi_Buffer {
 	channel_t chan;
@@ -35,6 +35,7 @@ void Music_Emu::clear_track_vars()
 	current_track_   = -1;
 	out_time         = 0;
 	emu_time         = 0;
+	emu_skipped      = 0;
 	emu_track_ended_ = true;
 	track_ended_     = true;
 	fade_start       = INT_MAX / 2 + 1;
@@ -176,6 +177,7 @@ blargg_err_t Music_Emu::start_track( int track )
 				break;
 		}
 		
+		emu_skipped   = emu_time - buf_remain;
 		emu_time      = buf_remain;
 		out_time      = 0;
 		silence_time  = 0;
@@ -226,8 +228,23 @@ long Music_Emu::tell() const
 
 blargg_err_t Music_Emu::seek_samples( long time )
 {
-	if ( time < out_time )
+	// a snapshot is only useful if it lies past what has already been emulated
+	long earliest = emu_skipped + (time < out_time ? 0 : emu_time);
+	long keyframe = restore_keyframe_( earliest, emu_skipped + time );
+	if ( keyframe >= 0 )
+	{
+		out_time         = keyframe - emu_skipped;
+		emu_time         = out_time;
+		emu_track_ended_ = false;
+		track_ended_     = false;
+		silence_time     = emu_time;
+		silence_count    = 0;
+		buf_remain       = 0;
+	}
+	else if ( time < out_time )
+	{
 		RETURN_ERR( start_track( current_track_ ) );
+	}
 	return skip( time - out_time );
 }
 
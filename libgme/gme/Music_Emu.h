@@ -151,6 +151,14 @@ protected:
 	virtual blargg_err_t start_track_( int ) = 0; // tempo is set before this
 	virtual blargg_err_t play_( long count, sample_t* out ) = 0;
 	virtual blargg_err_t skip_( long count );
+	
+	// Restore the latest state snapshot taken between samples 'earliest' and
+	// 'latest' of the emulator's output since start_track_(), and return its
+	// position. Returns -1 if no such snapshot exists (the default).
+	virtual long restore_keyframe_( long /* earliest */, long /* latest */ ) { return -1; }
+	
+	// returns the number of output channels, i.e. usually 2 for stereo, unlesss multi_channel_ == true
+	int out_channels() const { return this->multi_channel() ? 2*8 : 2; }
 protected:
 	virtual void unload();
 	virtual void pre_load();
@@ -166,9 +174,6 @@ private:
 	double gain_;
 	bool multi_channel_;
 
-	// returns the number of output channels, i.e. usually 2 for stereo, unlesss multi_channel_ == true
-	int out_channels() const { return this->multi_channel() ? 2*8 : 2; }
-
 	long sample_rate_;
 	blargg_long msec_to_samples( blargg_long msec ) const;
 	
@@ -176,6 +181,7 @@ private:
 	int current_track_;
 	blargg_long out_time;  // number of samples played since start of track
 	blargg_long emu_time;  // number of samples emulator has generated since start of track
+	blargg_long emu_skipped; // number of samples emulator generated before emu_time 0 (initial silence)
 	bool emu_track_ended_; // emulator has reached end of track
 	bool emu_autoload_playback_limit_; // whether to load and obey track length by default
 	volatile bool track_ended_;
@@ -204,28 +204,13 @@ void Nes_Apu::run_until_( nes_time_t end_time )
 				triangle.clock_length( 0x80 ); // different bit for halt flag on triangle
 				if (apu_log_enabled) {
 					if (!(square1.regs[0] & 0x20) && old_square1_length_counter > 0 && square1.length_counter <= 0) {
-						apu_log_t entry {
-							past_timeframe_cycles + time,
-							apu_log_event::timeout
-						};
-						entry.channel = 0;
-						apu_log.append(entry);
+						apu_log.append( past_timeframe_cycles + time, apu_log_event::timeout, 0, 0, 0 );
 					}
 					if (!(square2.regs[0] & 0x20) && old_square2_length_counter > 0 && square2.length_counter <= 0) {
-						apu_log_t entry {
-							past_timeframe_cycles + time,
-							apu_log_event::timeout
-						};
-						entry.channel = 1;
-						apu_log.append(entry);
+						apu_log.append( past_timeframe_cycles + time, apu_log_event::timeout, 0, 0, 1 );
 					}
 					if (!(triangle.regs[0] & 0x80) && old_triangle_length_counter > 0 && triangle.length_counter <= 0) {
-						apu_log_t entry {
-							past_timeframe_cycles + time,
-							apu_log_event::timeout
-						};
-						entry.channel = 2;
-						apu_log.append(entry);
+						apu_log.append( past_timeframe_cycles + time, apu_log_event::timeout, 0, 0, 2 );
 					}
 				}
 
@@ -235,22 +220,10 @@ void Nes_Apu::run_until_( nes_time_t end_time )
 				square2_period = ((square2.regs[3] & 0x07) << 8) + square2.regs[2];
 				if (apu_log_enabled) {
 					if (square1_period != old_square1_period) {
-						apu_log_t entry {
-							past_timeframe_cycles + time,
-							apu_log_event::sweep
-						};
-						entry.channel = 0;
-						entry.data = square1_period;
-						apu_log.append(entry);
+						apu_log.append( past_timeframe_cycles + time, apu_log_event::sweep, 0, square1_period, 0 );
 					}
 					if (square2_period != old_square2_period) {
-						apu_log_t entry {
-							past_timeframe_cycles + time,
-							apu_log_event::sweep
-						};
-						entry.channel = 1;
-						entry.data = square2_period;
-						apu_log.append(entry);
+						apu_log.append( past_timeframe_cycles + time, apu_log_event::sweep, 0, square2_period, 1 );
 					}
 				}
 
@@ -279,19 +252,9 @@ void Nes_Apu::run_until_( nes_time_t end_time )
 		triangle.clock_linear_counter();
 		if (apu_log_enabled) {
 			if (old_triangle_linear_counter > 0 && triangle.linear_counter <= 0) {
-				apu_log_t entry {
-					past_timeframe_cycles + time,
-					apu_log_event::timeout_linear
-				};
-				entry.channel = 2;
-				apu_log.append(entry);
+				apu_log.append( past_timeframe_cycles + time, apu_log_event::timeout_linear, 0, 0, 2 );
 			} else if (old_triangle_linear_counter <= 0 && triangle.linear_counter > 0) {
-				apu_log_t entry {
-					past_timeframe_cycles + time,
-					apu_log_event::reloaded_linear
-				};
-				entry.channel = 2;
-				apu_log.append(entry);
+				apu_log.append( past_timeframe_cycles + time, apu_log_event::reloaded_linear, 0, 0, 2 );
 			}
 		}
 		square1.clock_envelope();
@@ -366,18 +329,15 @@ void Nes_Apu::write_register( nes_time_t time, nes_addr_t addr, int data )
 	if ( unsigned (addr - start_addr) > end_addr - start_addr )
 		return;
 
+	run_until_( time );
+	
+	// logged after run_until_() so that any frame events it logs come first,
+	// keeping the log in cycle order
 	if (apu_log_enabled) {
-		apu_log_t entry {
-			past_timeframe_cycles + time,
-			apu_log_event::register_write
-		};
-		entry.address = addr;
-		entry.data = static_cast<char>(data);
-		apu_log.append(entry);
+		apu_log.append( past_timeframe_cycles + time, apu_log_event::register_write,
+				addr, static_cast<char>(data) );
 	}
 	
-	run_until_( time );
-	
 	if ( addr < 0x4014 )
 	{
 		// Write to channel
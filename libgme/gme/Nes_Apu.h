@@ -5,32 +5,11 @@
 #define NES_APU_H
 
 #include "blargg_common.h"
-
-#include <QList>
+#include "Apu_Log.h"
 
 typedef blargg_long nes_time_t; // CPU clock cycle count
 typedef unsigned nes_addr_t; // 16-bit memory address
 
-enum apu_log_event {
-	register_write,
-	timeout,
-	timeout_linear,
-	reloaded_linear,
-	sweep
-};
-
-struct apu_log_t {
-	apu_log_t (long long cpu_cycle, apu_log_event event) : cpu_cycle(cpu_cycle), event(event) {};
-	bool operator<(const apu_log_t &other) const {
-		return this->cpu_cycle < other.cpu_cycle;
-	}
-	long long cpu_cycle;
-	apu_log_event event;
-	nes_addr_t address = 0;
-	short data = 0;
-	char channel = 0;
-};
-
 #include "Nes_Oscs.h"
 
 struct apu_state_t;
@@ -116,7 +95,7 @@ public:
 	// accounted for (i.e. inserting CPU wait states).
 	void run_until( nes_time_t );
 
-	QList<apu_log_t> apu_log;
+	Apu_Log apu_log;
 	bool apu_log_enabled = false;
 	
 public:
@@ -150,7 +129,7 @@ private:
 	int frame; // current frame (0-3)
 	// Reminder: the following timeframes are twentieths of a second, as dictated by Classic_Emu::set_sample_rate_
 	// and are not related the the APU's "frame counter".
-	int past_timeframe_cycles;
+	long long past_timeframe_cycles;
 	int osc_enables;
 	int frame_mode;
 	bool irq_flag;
@@ -46,6 +46,34 @@ void Nes_Namco_Apu::output( Blip_Buffer* buf )
 		osc_output( i, buf );
 }
 
+void Nes_Namco_Apu::save_state( namco_state_t* out ) const
+{
+	out->addr = addr_reg;
+	out->unused = 0;
+	for ( int r = 0; r < reg_count; r++ )
+		out->regs [r] = reg [r];
+	
+	for ( int i = 0; i < osc_count; i++ )
+	{
+		out->positions [i] = oscs [i].wave_pos;
+		out->delays    [i] = oscs [i].delay;
+	}
+}
+
+void Nes_Namco_Apu::load_state( namco_state_t const& in )
+{
+	reset();
+	addr_reg = in.addr;
+	for ( int r = 0; r < reg_count; r++ )
+		reg [r] = in.regs [r];
+	
+	for ( int i = 0; i < osc_count; i++ )
+	{
+		oscs [i].wave_pos = in.positions [i];
+		oscs [i].delay    = in.delays    [i];
+	}
+}
+
 /*
 void Nes_Namco_Apu::reflect_state( Tagged_Data& data )
 {
@@ -29,7 +29,7 @@ public:
 	enum { addr_reg_addr = 0xF800 };
 	void write_addr( int );
 	
-	// to do: implement save/restore
+	// Save/load exact emulation state
 	void save_state( namco_state_t* out ) const;
 	void load_state( namco_state_t const& );
 	
@@ -60,7 +60,7 @@ private:
 	uint8_t& access();
 	void run_until( blip_time_t );
 };
-/*
+
 struct namco_state_t
 {
 	uint8_t regs [0x80];
@@ -69,7 +69,6 @@ struct namco_state_t
 	uint8_t positions [8];
 	uint32_t delays [8];
 };
-*/
 
 inline uint8_t& Nes_Namco_Apu::access()
 {
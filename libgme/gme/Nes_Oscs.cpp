@@ -194,7 +194,7 @@ inline nes_time_t Nes_Triangle::maintain_phase( nes_time_t time, nes_time_t end_
 	if ( remain > 0 )
 	{
 		int count = (remain + timer_period - 1) / timer_period;
-		phase = ((unsigned) phase + 1 - count) & (phase_range * 2 - 1);
+		phase = ((unsigned) phase - 1 - count) & (phase_range * 2 - 1);
 		phase++;
 		time += (blargg_long) count * timer_period;
 	}
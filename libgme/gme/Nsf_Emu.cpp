@@ -2,6 +2,7 @@
 
 #include "Nsf_Emu.h"
 
+#include "apu_state.h"
 #include "blargg_endian.h"
 #include <string.h>
 #include <stdio.h>
@@ -40,6 +41,26 @@ Nsf_Emu::equalizer_t const Nsf_Emu::nes_eq     =
 Nsf_Emu::equalizer_t const Nsf_Emu::famicom_eq =
 	Music_Emu::make_equalizer( -15.0, 80 );
 
+// Complete emulator state between two frames, saved by save_keyframe_()
+struct Nsf_Emu::keyframe_t
+{
+	long pos; // samples played since start of track
+	Nes_Cpu::registers_t r;
+	Nes_Cpu::registers_t saved_state;
+	nes_time_t next_play;
+	int play_extra;
+	int play_ready;
+	byte banks [bank_count];
+	byte low_mem [0x800];
+	byte sram [0x2000];
+	apu_state_t apu;
+	#if !NSF_EMU_APU_ONLY
+		namco_state_t namco;
+		vrc6_apu_state_t vrc6;
+		fme7_apu_state_t fme7;
+	#endif
+};
+
 int Nsf_Emu::pcm_read( void* emu, nes_addr_t addr )
 {
 	return *((Nsf_Emu*) emu)->cpu::get_code( addr );
@@ -51,6 +72,10 @@ Nsf_Emu::Nsf_Emu()
 	namco = 0;
 	fme7  = 0;
 	
+	keyframe_count_    = 0;
+	keyframe_track     = -1;
+	keyframe_interval  = 0;
+	
 	set_type( gme_nsf_type );
 	set_silence_lookahead( 6 );
 	apu.dmc_reader( pcm_read, this );
@@ -77,6 +102,7 @@ void Nsf_Emu::unload()
 	#endif
 	
 	rom.clear();
+	clear_keyframes();
 	Music_Emu::unload();
 }
 
@@ -161,6 +187,7 @@ void Nsf_Emu::set_tempo_( double t )
 		play_period = long (playback_rate * clock_rate_ / (1000000.0 / clock_divisor * t));
 
 	apu.set_tempo( t );
+	clear_keyframes();
 }
 
 blargg_err_t Nsf_Emu::init_sound()
@@ -457,6 +484,10 @@ blargg_err_t Nsf_Emu::start_track_( int track )
 {
 	RETURN_ERR( Classic_Emu::start_track_( track ) );
 	
+	if ( track != keyframe_track )
+		clear_keyframes();
+	keyframe_track = track;
+	
 	memset( low_mem, 0, sizeof low_mem );
 	memset( sram,    0, sizeof sram );
 	
@@ -563,3 +594,95 @@ blargg_err_t Nsf_Emu::run_clocks( blip_time_t& duration, int )
 	
 	return 0;
 }
+
+// Keyframes
+
+void Nsf_Emu::clear_keyframes()
+{
+	keyframes.clear();
+	keyframe_count_ = 0;
+	keyframe_track  = -1;
+}
+
+void Nsf_Emu::set_keyframe_interval( double sec )
+{
+	keyframe_interval = sec;
+	if ( sec <= 0 )
+		clear_keyframes();
+}
+
+void Nsf_Emu::save_keyframe_( long pos )
+{
+	if ( keyframe_interval <= 0 )
+		return;
+	
+	long interval = (long) (keyframe_interval * sample_rate()) * out_channels();
+	long last = (keyframe_count_ ? keyframes [keyframe_count_ - 1].pos : 0);
+	if ( pos < last + interval )
+		return;
+	
+	if ( keyframe_count_ >= (int) keyframes.size() )
+	{
+		if ( keyframes.resize( keyframes.size() * 2 + 16 ) )
+			return; // out of memory; seeks just fall back to emulating
+	}
+	
+	keyframe_t& k = keyframes [keyframe_count_++];
+	k.pos         = pos;
+	k.r           = cpu::r;
+	k.saved_state = saved_state;
+	k.next_play   = next_play;
+	k.play_extra  = play_extra;
+	k.play_ready  = play_ready;
+	memcpy( k.banks,   banks,   sizeof k.banks );
+	memcpy( k.low_mem, low_mem, sizeof k.low_mem );
+	memcpy( k.sram,    sram,    sizeof k.sram );
+	apu.save_state( &k.apu );
+	#if !NSF_EMU_APU_ONLY
+	{
+		if ( namco ) namco->save_state( &k.namco );
+		if ( vrc6  ) vrc6 ->save_state( &k.vrc6 );
+		if ( fme7  ) fme7 ->save_state( &k.fme7 );
+	}
+	#endif
+}
+
+long Nsf_Emu::restore_keyframe_( long earliest, long latest )
+{
+	// latest keyframe at or before 'latest'
+	int lo = 0;
+	int hi = keyframe_count_;
+	while ( lo < hi )
+	{
+		int mid = (lo + hi) / 2;
+		if ( keyframes [mid].pos <= latest )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if ( !lo || keyframes [lo - 1].pos < earliest )
+		return -1;
+	
+	keyframe_t const& k = keyframes [lo - 1];
+	cpu::r      = k.r;
+	saved_state = k.saved_state;
+	next_play   = k.next_play;
+	play_extra  = k.play_extra;
+	play_ready  = k.play_ready;
+	memcpy( low_mem, k.low_mem, sizeof low_mem );
+	memcpy( sram,    k.sram,    sizeof sram );
+	for ( int i = 0; i < bank_count; ++i )
+		cpu_write( bank_select_addr + i, k.banks [i] );
+	
+	apu.load_state( k.apu );
+	#if !NSF_EMU_APU_ONLY
+	{
+		if ( namco ) namco->load_state( k.namco );
+		if ( vrc6  ) vrc6 ->load_state( k.vrc6 );
+		if ( fme7  ) fme7 ->load_state( k.fme7 );
+	}
+	#endif
+	
+	keyframe_restored( k.pos );
+	return k.pos;
+}
@@ -48,6 +48,15 @@ public:
 	blargg_err_t load( header_t const& h, Data_Reader& in ) // use Remaining_Reader
 			{ return load_remaining_( &h, sizeof h, in ); }
 
+	// Save a snapshot of the complete emulator state every 'sec' seconds of
+	// output while a track plays, so that later seeks within the same track
+	// resume from the nearest snapshot instead of re-emulating from the start.
+	// 0 (the default) disables snapshots and discards any already taken.
+	void set_keyframe_interval( double sec );
+	
+	// Number of snapshots held for the current track
+	int keyframe_count() const { return keyframe_count_; }
+	
 public:
 	Nsf_Emu();
 	~Nsf_Emu();
@@ -61,9 +70,12 @@ protected:
 	void set_voice( int, Blip_Buffer*, Blip_Buffer*, Blip_Buffer* );
 	void update_eq( blip_eq_t const& );
 	void unload();
+	void save_keyframe_( long );
+	long restore_keyframe_( long, long );
 protected:
 	enum { bank_count = 8 };
 	byte initial_banks [bank_count];
+	byte banks [bank_count]; // currently selected
 	nes_addr_t init_addr;
 	nes_addr_t play_addr;
 	double clock_rate_;
@@ -98,6 +110,14 @@ private:
 	
 	header_t header_;
 	
+	// keyframes
+	struct keyframe_t;
+	blargg_vector<keyframe_t> keyframes;
+	int keyframe_count_;
+	int keyframe_track;
+	double keyframe_interval; // seconds
+	void clear_keyframes();
+	
 	enum { sram_addr = 0x6000 };
 	byte sram [0x2000];
 	byte unmapped_code [Nes_Cpu::page_size + 8];
@@ -0,0 +1,151 @@
+// Nes_Snd_Emu 0.1.8. http://www.slack.net/~ant/
+
+#include "Nes_Apu.h"
+
+#include "apu_state.h"
+#include <string.h>
+
+/* Copyright (C) 2003-2006 Shay Green. This module is free software; you
+can redistribute it and/or modify it under the terms of the GNU Lesser
+General Public License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version. This
+module is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details. You should have received a copy of the GNU Lesser General Public
+License along with this module; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA */
+
+#include "blargg_source.h"
+
+static void save_osc( Nes_Osc const& osc, apu_state_t::osc_t* out )
+{
+	memcpy( out->regs, osc.regs, sizeof out->regs );
+	memcpy( out->reg_written, osc.reg_written, sizeof out->reg_written );
+	out->length_counter = osc.length_counter;
+	out->delay          = osc.delay;
+}
+
+static void load_osc( Nes_Osc& osc, apu_state_t::osc_t const& in )
+{
+	memcpy( osc.regs, in.regs, sizeof osc.regs );
+	memcpy( osc.reg_written, in.reg_written, sizeof osc.reg_written );
+	osc.length_counter = in.length_counter;
+	osc.delay          = in.delay;
+
+	// output restarts from zero, matching a freshly cleared Blip_Buffer
+	osc.last_amp       = 0;
+}
+
+static void save_env( Nes_Envelope const& osc, apu_state_t::env_t* out )
+{
+	out->envelope  = osc.envelope;
+	out->env_delay = osc.env_delay;
+}
+
+static void load_env( Nes_Envelope& osc, apu_state_t::env_t const& in )
+{
+	osc.envelope  = in.envelope;
+	osc.env_delay = in.env_delay;
+}
+
+static void save_square( Nes_Square const& osc, apu_state_t::square_t* out )
+{
+	save_osc( osc, &out->osc );
+	save_env( osc, &out->env );
+	out->phase       = osc.phase;
+	out->sweep_delay = osc.sweep_delay;
+}
+
+static void load_square( Nes_Square& osc, apu_state_t::square_t const& in )
+{
+	load_osc( osc, in.osc );
+	load_env( osc, in.env );
+	osc.phase       = in.phase;
+	osc.sweep_delay = in.sweep_delay;
+}
+
+void Nes_Apu::save_state( apu_state_t* out ) const
+{
+	save_square( square1, &out->square1 );
+	save_square( square2, &out->square2 );
+
+	save_osc( triangle, &out->triangle.osc );
+	out->triangle.phase          = triangle.phase;
+	out->triangle.linear_counter = triangle.linear_counter;
+
+	save_osc( noise, &out->noise.osc );
+	save_env( noise, &out->noise.env );
+	out->noise.noise = noise.noise;
+
+	save_osc( dmc, &out->dmc.osc );
+	out->dmc.address     = dmc.address;
+	out->dmc.period      = dmc.period;
+	out->dmc.buf         = dmc.buf;
+	out->dmc.bits_remain = dmc.bits_remain;
+	out->dmc.bits        = dmc.bits;
+	out->dmc.buf_full    = dmc.buf_full;
+	out->dmc.silence     = dmc.silence;
+	out->dmc.dac         = dmc.dac;
+	out->dmc.next_irq    = dmc.next_irq;
+	out->dmc.irq_enabled = dmc.irq_enabled;
+	out->dmc.irq_flag    = dmc.irq_flag;
+	out->dmc.pal_mode    = dmc.pal_mode;
+
+	out->apu.last_time             = last_time;
+	out->apu.last_dmc_time         = last_dmc_time;
+	out->apu.earliest_irq          = earliest_irq_;
+	out->apu.next_irq              = next_irq;
+	out->apu.frame_period          = frame_period;
+	out->apu.frame_delay           = frame_delay;
+	out->apu.frame                 = frame;
+	out->apu.past_timeframe_cycles = past_timeframe_cycles;
+	out->apu.osc_enables           = osc_enables;
+	out->apu.frame_mode            = frame_mode;
+	out->apu.irq_flag              = irq_flag;
+}
+
+void Nes_Apu::load_state( apu_state_t const& in )
+{
+	// Registers are restored directly rather than replayed through
+	// write_register(), so apu_log is left untouched.
+	load_square( square1, in.square1 );
+	load_square( square2, in.square2 );
+
+	load_osc( triangle, in.triangle.osc );
+	triangle.phase          = in.triangle.phase;
+	triangle.linear_counter = in.triangle.linear_counter;
+
+	load_osc( noise, in.noise.osc );
+	load_env( noise, in.noise.env );
+	noise.noise = in.noise.noise;
+
+	load_osc( dmc, in.dmc.osc );
+	dmc.address     = in.dmc.address;
+	dmc.period      = in.dmc.period;
+	dmc.buf         = in.dmc.buf;
+	dmc.bits_remain = in.dmc.bits_remain;
+	dmc.bits        = in.dmc.bits;
+	dmc.buf_full    = in.dmc.buf_full;
+	dmc.silence     = in.dmc.silence;
+	dmc.dac         = in.dmc.dac;
+	dmc.next_irq    = in.dmc.next_irq;
+	dmc.irq_enabled = in.dmc.irq_enabled;
+	dmc.irq_flag    = in.dmc.irq_flag;
+	dmc.pal_mode    = in.dmc.pal_mode;
+
+	last_time             = in.apu.last_time;
+	last_dmc_time         = in.apu.last_dmc_time;
+	earliest_irq_         = in.apu.earliest_irq;
+	next_irq              = in.apu.next_irq;
+	frame_period          = in.apu.frame_period;
+	frame_delay           = in.apu.frame_delay;
+	frame                 = in.apu.frame;
+	past_timeframe_cycles = in.apu.past_timeframe_cycles;
+	osc_enables           = in.apu.osc_enables;
+	frame_mode            = in.apu.frame_mode;
+	irq_flag              = in.apu.irq_flag;
+
+	if ( irq_notifier_ )
+		irq_notifier_( irq_data );
+}
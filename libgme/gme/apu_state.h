@@ -0,0 +1,81 @@
+// NES APU state snapshot support
+
+// Nes_Snd_Emu 0.1.8
+#ifndef APU_STATE_H
+#define APU_STATE_H
+
+#include "blargg_common.h"
+
+// Exact emulation state of Nes_Apu, filled by Nes_Apu::save_state() and
+// restored by Nes_Apu::load_state(). Intended for in-memory snapshots only;
+// the layout is not meant to be written to disk.
+struct apu_state_t
+{
+	typedef uint8_t byte;
+
+	struct osc_t {
+		byte regs [4];
+		bool reg_written [4];
+		int length_counter;
+		int delay;
+	};
+
+	struct env_t {
+		int envelope;
+		int env_delay;
+	};
+
+	struct square_t {
+		osc_t osc;
+		env_t env;
+		int phase;
+		int sweep_delay;
+	};
+
+	square_t square1;
+	square_t square2;
+
+	struct triangle_t {
+		osc_t osc;
+		int phase;
+		int linear_counter;
+	} triangle;
+
+	struct noise_t {
+		osc_t osc;
+		env_t env;
+		int noise;
+	} noise;
+
+	struct dmc_t {
+		osc_t osc;
+		int address;
+		int period;
+		int buf;
+		int bits_remain;
+		int bits;
+		bool buf_full;
+		bool silence;
+		int dac;
+		blargg_long next_irq;
+		bool irq_enabled;
+		bool irq_flag;
+		bool pal_mode;
+	} dmc;
+
+	struct apu_t {
+		blargg_long last_time;
+		blargg_long last_dmc_time;
+		blargg_long earliest_irq;
+		blargg_long next_irq;
+		int frame_period;
+		int frame_delay;
+		int frame;
+		long long past_timeframe_cycles;
+		int osc_enables;
+		int frame_mode;
+		bool irq_flag;
+	} apu;
+};
+
+#endif
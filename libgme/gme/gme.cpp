@@ -5,6 +5,8 @@
 #include "gme_types.h"
 #if !GME_DISABLE_STEREO_DEPTH
 #include "Effects_Buffer.h"
+#else
+#include "Multi_Buffer.h"
 #endif
 #include "blargg_endian.h"
 #include <string.h>
@@ -136,7 +138,7 @@ gme_err_t gme_identify_file( const char* path, gme_type_t* type_out )
 	return 0;
 }
 
-gme_err_t gme_open_data( void const* data, long size, Music_Emu** out, int sample_rate )
+static gme_err_t open_data( void const* data, long size, Music_Emu** out, int sample_rate, bool multi_channel )
 {
 	require( (data || !size) && out );
 	*out = 0;
@@ -147,7 +149,7 @@ gme_err_t gme_open_data( void const* data, long size, Music_Emu** out, int sampl
 	if ( !file_type )
 		return gme_wrong_file_type;
 
-	Music_Emu* emu = gme_new_emu( file_type, sample_rate );
+	Music_Emu* emu = multi_channel ? gme_new_emu_multi_channel( file_type, sample_rate ) : gme_new_emu( file_type, sample_rate );
 	CHECK_ALLOC( emu );
 
 	gme_err_t err = gme_load_data( emu, data, size );
@@ -160,6 +162,16 @@ gme_err_t gme_open_data( void const* data, long size, Music_Emu** out, int sampl
 	return err;
 }
 
+gme_err_t gme_open_data( void const* data, long size, Music_Emu** out, int sample_rate )
+{
+	return open_data( data, size, out, sample_rate, false );
+}
+
+gme_err_t gme_open_data_multi_channel( void const* data, long size, Music_Emu** out, int sample_rate )
+{
+	return open_data( data, size, out, sample_rate, true );
+}
+
 gme_err_t gme_open_file( const char* path, Music_Emu** out, int sample_rate )
 {
 	require( path && out );
@@ -236,6 +248,16 @@ Music_Emu* gme_internal_new_emu_( gme_type_t type, int rate, bool multi_channel
 			}
 
 			if ( !(type->flags_ & 1) || me->effects_buffer )
+		#else
+			// without Effects_Buffer, multi-channel output is one stereo pair per voice
+			if ( multi_channel && !me->set_multi_channel( true ) )
+			{
+				me->effects_buffer = BLARGG_NEW Voice_Buffer;
+				if ( me->effects_buffer )
+					me->set_buffer( me->effects_buffer );
+			}
+			
+			if ( !me->multi_channel() || me->effects_buffer )
 		#endif
 			{
 				if ( !me->set_sample_rate( rate ) )
@@ -222,6 +222,10 @@ extern BLARGG_EXPORT const char* const gme_wrong_file_type;
  * The resulting Music_Emu object will be set to single channel mode. */
 BLARGG_EXPORT gme_err_t gme_open_data( void const* data, long size, Music_Emu** out, int sample_rate );
 
+/* Same as gme_open_data(), but the Music_Emu object will be set to multi channel mode
+ * (see gme_multi_channel). */
+BLARGG_EXPORT gme_err_t gme_open_data_multi_channel( void const* data, long size, Music_Emu** out, int sample_rate );
+
 /* Determine likely game music type based on first four bytes of file. Returns
 string containing proper file suffix (i.e. "NSF", "SPC", etc.) or "" if
 file header is not recognized. */
@@ -0,0 +1,34 @@
+// Nes_Snd_Emu 0.1.8. http://www.slack.net/~ant/
+
+#include "nes_mixer.h"
+
+/* Copyright (C) 2003-2006 Shay Green. This module is free software; you
+can redistribute it and/or modify it under the terms of the GNU Lesser
+General Public License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version. This
+module is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details. You should have received a copy of the GNU Lesser General Public
+License along with this module; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA */
+
+// Expand to f( n ) for n, n + 1, ... in runs of 1, 10 and 100 entries
+#define MIX_1( f, n )   float (f( n ))
+#define MIX_10( f, n )  MIX_1( f, n ), MIX_1( f, n + 1 ), MIX_1( f, n + 2 ), MIX_1( f, n + 3 ),\
+		MIX_1( f, n + 4 ), MIX_1( f, n + 5 ), MIX_1( f, n + 6 ), MIX_1( f, n + 7 ),\
+		MIX_1( f, n + 8 ), MIX_1( f, n + 9 )
+#define MIX_100( f, n ) MIX_10( f, n ), MIX_10( f, n + 10 ), MIX_10( f, n + 20 ),\
+		MIX_10( f, n + 30 ), MIX_10( f, n + 40 ), MIX_10( f, n + 50 ),\
+		MIX_10( f, n + 60 ), MIX_10( f, n + 70 ), MIX_10( f, n + 80 ),\
+		MIX_10( f, n + 90 )
+
+float const nes_pulse_table [nes_pulse_table_size] = {
+	MIX_10( nes_pulse_out, 0 ), MIX_10( nes_pulse_out, 10 ), MIX_10( nes_pulse_out, 20 ),
+	MIX_1( nes_pulse_out, 30 )
+};
+
+float const nes_tnd_table [nes_tnd_table_size] = {
+	MIX_100( nes_tnd_out, 0 ), MIX_100( nes_tnd_out, 100 ),
+	MIX_1( nes_tnd_out, 200 ), MIX_1( nes_tnd_out, 201 ), MIX_1( nes_tnd_out, 202 )
+};
@@ -0,0 +1,40 @@
+// Nonlinear NES APU mixer as lookup tables
+
+// Nes_Snd_Emu 0.1.8
+#ifndef NES_MIXER_H
+#define NES_MIXER_H
+
+// Mixer output for the sum of both square volumes (0 to 30), using the
+// exact formula. Full scale is about 1.0 with the TND half included.
+inline constexpr double nes_pulse_out( int sum )
+{
+	return sum ? 95.88 / (8128.0 / sum + 100.0) : 0.0;
+}
+
+// Mixer output for 3 * triangle + 2 * noise + dmc (0 to 202). The exact
+// formula weighs each channel separately, so this is the usual single-sum
+// approximation of it.
+inline constexpr double nes_tnd_out( int sum )
+{
+	return sum ? 163.67 / (24329.0 / sum + 100.0) : 0.0;
+}
+
+int const nes_pulse_table_size = 31;
+int const nes_tnd_table_size = 203;
+
+// nes_pulse_out() and nes_tnd_out() for every sum, evaluated at compile time
+extern float const nes_pulse_table [nes_pulse_table_size];
+extern float const nes_tnd_table [nes_tnd_table_size];
+
+inline int nes_tnd_index( int triangle, int noise, int dmc )
+{
+	return 3 * triangle + 2 * noise + dmc;
+}
+
+// Mixer output for the given channel levels
+inline float nes_mix( int square1, int square2, int triangle, int noise, int dmc )
+{
+	return nes_pulse_table [square1 + square2] + nes_tnd_table [nes_tnd_index( triangle, noise, dmc )];
+}
+
+#endif
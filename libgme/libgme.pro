@@ -27,7 +27,9 @@ DEFINES += USE_GME_NSF
 DEFINES += USE_GME_NSFE
 
 # Input
-HEADERS += gme/blargg_common.h \
+HEADERS += gme/Apu_Log.h \
+           gme/apu_state.h \
+           gme/blargg_common.h \
            gme/blargg_config.h \
            gme/blargg_endian.h \
            gme/blargg_source.h \
@@ -43,12 +45,15 @@ HEADERS += gme/blargg_common.h \
            gme/Nes_Cpu.h \
            gme/nes_cpu_io.h \
            gme/Nes_Fme7_Apu.h \
+           gme/nes_mixer.h \
            gme/Nes_Namco_Apu.h \
            gme/Nes_Oscs.h \
            gme/Nes_Vrc6_Apu.h \
            gme/Nsf_Emu.h \
            gme/Nsfe_Emu.h
-SOURCES += gme/Blip_Buffer.cpp \
+SOURCES += gme/Apu_Log.cpp \
+           gme/apu_state.cpp \
+           gme/Blip_Buffer.cpp \
            gme/Classic_Emu.cpp \
            gme/Data_Reader.cpp \
            gme/gme.cpp \
@@ -59,6 +64,7 @@ SOURCES += gme/Blip_Buffer.cpp \
            gme/Nes_Apu.cpp \
            gme/Nes_Cpu.cpp \
            gme/Nes_Fme7_Apu.cpp \
+           gme/nes_mixer.cpp \
            gme/Nes_Namco_Apu.cpp \
            gme/Nes_Oscs.cpp \
            gme/Nes_Vrc6_Apu.cpp \
@@ -1,4 +1,7 @@
 TEMPLATE = subdirs
 SUBDIRS = libgme \
-    src
+    src \
+    cli \
+    tests
 src.depends = libgme
+cli.depends = libgme
@@ -1,5 +1,6 @@
 import QtQuick 2.0
 import QtQuick.Controls 2.5
+import Nestoration 1.0
 
 Item {
     id: toneViewer
@@ -119,22 +120,27 @@ Item {
                     }
 
                     Rectangle {
-                        property real position_ratio: (1789773.0 / 48000.0) / 4.0
                         height: parent.height
                         width: 1 / global_xScale
-                        x: player.position * position_ratio
+                        x: playback_clock.cycle
                         color: "yellow"
                         visible: true
                     }
 
-                    Row {
+                    ToneRoll {
                         id: mainrow
                         height: parent.height
-
-                        Repeater {
-                            model: mainrepeater_model
-                            delegate: SquareTone {}
-                        }
+                        width: implicitWidth
+                        model: mainrepeater_model
+                        lowestTone: audiofile.lowestTone
+                        highestTone: audiofile.highestTone
+                        paddedHighestTone: toneViewer.paddedHighestTone
+                        noteHeight: toneViewer.noteHeight
+                        noteSpacing: toneViewer.noteSpacing
+                        xScale: global_xScale
+                        viewportX: global_scrollbar.position * width
+                        viewportWidth: global_scrollbar.size * width
+                        onToneClicked: show_tone(mainrepeater_model.get(row))
                     }
                 }
             }
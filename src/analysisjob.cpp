@@ -0,0 +1,96 @@
+#include "analysisjob.h"
+#include "toneextractor.h"
+#include "gme/Nsf_Emu.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+const double KEYFRAME_INTERVAL_SEC = 5.0;
+const double ANALYSIS_CHUNK_SEC = 1.0; // Emulated between progress reports and cancellation checks.
+
+AnalysisJob::AnalysisJob(quint64 job_id, QSharedPointer<QAtomicInt> cancelled, QByteArray file_data,
+                         int sample_rate, qint16 track_num, qreal length_sec, bool streaming)
+    : job_id(job_id), cancelled(cancelled), file_data(file_data), sample_rate(sample_rate),
+      track_num(track_num), length_sec(length_sec), streaming(streaming)
+{
+    // The job deletes itself with deleteLater() once its signals have been sent.
+    this->setAutoDelete(false);
+}
+
+void AnalysisJob::run() {
+    if (this->cancelled->loadAcquire()) {
+        this->deleteLater();
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    // Each voice is rendered to its own channel, so the player can mix them as it plays.
+    Music_Emu *emu { nullptr };
+    gme_err_t err = gme_open_data_multi_channel(this->file_data.constData(), this->file_data.size(), &emu, this->sample_rate);
+    if (!err && gme_type(emu) != gme_nsf_type && gme_type(emu) != gme_nsfe_type) {
+        err = "Only NSF files can be analysed";
+    }
+    if (err) {
+        gme_delete(emu);
+        emit this->failed(this->job_id, err);
+        this->deleteLater();
+        return;
+    }
+    Nsf_Emu *nsf_emu = static_cast<Nsf_Emu*>(emu);
+    Nes_Apu *apu = nsf_emu->apu_();
+    gme_enable_accuracy(emu, 1);
+    // Keyframes are captured while the track is analysed and let later seeks skip most re-emulation.
+    nsf_emu->set_keyframe_interval(KEYFRAME_INTERVAL_SEC);
+    apu->apu_log_enabled = true;
+    err = gme_start_track(emu, this->track_num);
+
+    // Sample counts include every channel the emulator puts out: a stereo pair per voice.
+    const int channels = gme_multi_channel(emu) ? 16 : 2;
+    const long total = this->sample_rate * channels * (this->length_sec + 1);
+    const long chunk_size = this->sample_rate * channels * ANALYSIS_CHUNK_SEC;
+    ToneExtractor extractor(this->length_sec * 1789773); /* TODO: Don't hard-code the CPU frequency. */
+    TrackAnalysis analysis;
+    analysis.track_num = this->track_num;
+    analysis.length_sec = this->length_sec;
+    long remain = total;
+    while (!err && remain > 0) {
+        if (this->cancelled->loadAcquire()) {
+            gme_delete(emu);
+            this->deleteLater();
+            return;
+        }
+        long chunk = std::min(remain, chunk_size);
+        // Only the APU log is needed here, so skip sound synthesis entirely.
+        err = nsf_emu->analyze(chunk);
+        remain -= chunk;
+        extractor.feed(apu->apu_log);
+        apu->apu_log.clear(false);
+        for (int channel_i = 0; channel_i < 3; channel_i += 1) {
+            QVector<ToneObject> tones = remain > 0 ? extractor.take_finished(channel_i) : extractor.finish(channel_i);
+            analysis.tones[channel_i] += tones;
+            if (this->streaming && !tones.isEmpty()) {
+                emit this->tonesFound(this->job_id, channel_i, tones);
+            }
+        }
+        if (this->streaming) {
+            emit this->progressChanged(this->job_id, 1.0 - 1.0 * remain / total);
+        }
+    }
+    apu->apu_log_enabled = false;
+    apu->apu_log.clear();
+    if (!err) {
+        // Analysis leaves the emulator past the end of the track, so restart it for playback.
+        err = gme_start_track(emu, this->track_num);
+    }
+    if (err) {
+        gme_delete(emu);
+        emit this->failed(this->job_id, err);
+    } else {
+        analysis.emu = emu;
+        analysis.analysis_msec = timer.elapsed();
+        emit this->finished(this->job_id, analysis);
+    }
+    this->deleteLater();
+}
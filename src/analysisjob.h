@@ -0,0 +1,60 @@
+#ifndef ANALYSISJOB_H
+#define ANALYSISJOB_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QObject>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QVector>
+
+#include "toneobject.h"
+
+class Music_Emu;
+
+// Everything known about one track once it has been analysed.
+struct TrackAnalysis {
+    qint16 track_num = -1;
+    qreal length_sec = 0;
+    QVector<ToneObject> tones[3];
+    // How long the job took, from opening the emulator to restarting it.
+    qint64 analysis_msec = 0;
+    // Started at the beginning of the track, with keyframes for seeking.
+    Music_Emu *emu = nullptr;
+};
+
+Q_DECLARE_METATYPE(TrackAnalysis)
+
+// Emulates one NSF track on a thread pool and extracts its tones. Each job
+// opens its own emulator from the file data, so jobs never share state with
+// each other or with the player. Setting the shared cancel flag stops the
+// job at the next chunk boundary.
+class AnalysisJob : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    AnalysisJob(quint64 job_id, QSharedPointer<QAtomicInt> cancelled, QByteArray file_data,
+                int sample_rate, qint16 track_num, qreal length_sec, bool streaming);
+
+    void run() override;
+
+signals:
+    // Only emitted by streaming jobs, after every chunk.
+    void progressChanged(quint64 job_id, qreal progress);
+    void tonesFound(quint64 job_id, int channel_i, QVector<ToneObject> tones);
+    // Ownership of analysis.emu passes to the receiver.
+    void finished(quint64 job_id, TrackAnalysis analysis);
+    void failed(quint64 job_id, QString error);
+
+private:
+    const quint64 job_id;
+    QSharedPointer<QAtomicInt> cancelled;
+    const QByteArray file_data;
+    const int sample_rate;
+    const qint16 track_num;
+    const qreal length_sec;
+    const bool streaming;
+};
+
+#endif // ANALYSISJOB_H
@@ -0,0 +1,106 @@
+#include "analysisscheduler.h"
+#include "gme/gme.h"
+
+#include <QDebug>
+
+const int FOREGROUND_PRIORITY = 1;
+const int BACKGROUND_PRIORITY = 0;
+
+AnalysisScheduler::AnalysisScheduler(QObject *parent) : QObject(parent) {
+    qRegisterMetaType<QVector<ToneObject>>("QVector<ToneObject>");
+    qRegisterMetaType<TrackAnalysis>("TrackAnalysis");
+}
+
+AnalysisScheduler::~AnalysisScheduler() {
+    this->cancel_all();
+    this->pool.waitForDone();
+}
+
+void AnalysisScheduler::start(QByteArray file_data, int sample_rate, qint16 track_num, qreal length_sec) {
+    this->cancel();
+    this->job_id = this->next_job_id++;
+    this->cancelled = QSharedPointer<QAtomicInt>::create(0);
+    this->running = true;
+    bool streaming = true;
+    this->submit(new AnalysisJob { this->job_id, this->cancelled, file_data, sample_rate, track_num, length_sec, streaming },
+                 FOREGROUND_PRIORITY);
+}
+
+void AnalysisScheduler::start_all(QByteArray file_data, int sample_rate, QMap<qint16, qreal> track_lengths_sec) {
+    if (this->batch_remain) {
+        this->batch_cancelled->storeRelease(1);
+    }
+    this->batch_id = this->next_job_id++;
+    this->batch_cancelled = QSharedPointer<QAtomicInt>::create(0);
+    this->batch_remain = track_lengths_sec.size();
+    bool streaming = false;
+    for (auto track = track_lengths_sec.constBegin(); track != track_lengths_sec.constEnd(); ++track) {
+        this->submit(new AnalysisJob { this->batch_id, this->batch_cancelled, file_data, sample_rate,
+                                       track.key(), track.value(), streaming },
+                     BACKGROUND_PRIORITY);
+    }
+}
+
+void AnalysisScheduler::submit(AnalysisJob *job, int priority) {
+    QObject::connect(job, SIGNAL(progressChanged(quint64, qreal)),
+                     this, SLOT(handleProgress(quint64, qreal)));
+    QObject::connect(job, SIGNAL(tonesFound(quint64, int, QVector<ToneObject>)),
+                     this, SLOT(handleTones(quint64, int, QVector<ToneObject>)));
+    QObject::connect(job, SIGNAL(finished(quint64, TrackAnalysis)),
+                     this, SLOT(handleFinished(quint64, TrackAnalysis)));
+    QObject::connect(job, SIGNAL(failed(quint64, QString)),
+                     this, SLOT(handleFailed(quint64, QString)));
+    this->pool.start(job, priority);
+}
+
+void AnalysisScheduler::cancel() {
+    if (this->running) {
+        this->cancelled->storeRelease(1);
+        this->running = false;
+    }
+}
+
+void AnalysisScheduler::cancel_all() {
+    this->cancel();
+    if (this->batch_remain) {
+        this->batch_cancelled->storeRelease(1);
+        this->batch_remain = 0;
+    }
+}
+
+// Signals from a cancelled job may already be queued when it's cancelled,
+// so every handler checks that the result belongs to a live job.
+
+void AnalysisScheduler::handleProgress(quint64 job_id, qreal progress) {
+    if (this->running && job_id == this->job_id) {
+        emit this->progressChanged(progress);
+    }
+}
+
+void AnalysisScheduler::handleTones(quint64 job_id, int channel_i, QVector<ToneObject> tones) {
+    if (this->running && job_id == this->job_id) {
+        emit this->tonesFound(channel_i, tones);
+    }
+}
+
+void AnalysisScheduler::handleFinished(quint64 job_id, TrackAnalysis analysis) {
+    if (this->running && job_id == this->job_id) {
+        this->running = false;
+        emit this->finished(analysis);
+    } else if (this->batch_remain && job_id == this->batch_id) {
+        this->batch_remain -= 1;
+        emit this->trackAnalysed(analysis);
+    } else {
+        gme_delete(analysis.emu);
+    }
+}
+
+void AnalysisScheduler::handleFailed(quint64 job_id, QString error) {
+    if (this->running && job_id == this->job_id) {
+        this->running = false;
+        emit this->failed(error);
+    } else if (this->batch_remain && job_id == this->batch_id) {
+        this->batch_remain -= 1;
+        qDebug() << error;
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef ANALYSISSCHEDULER_H
+#define ANALYSISSCHEDULER_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QMap>
+#include <QObject>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QVector>
+
+#include "analysisjob.h"
+#include "toneobject.h"
+
+// Runs AnalysisJobs on a thread pool. There is at most one foreground job,
+// for the track the user selected; it streams its tones and starting another
+// one cancels it. Background jobs analyse a batch of tracks in parallel and
+// only report complete results. Results from cancelled jobs are never reported.
+class AnalysisScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AnalysisScheduler(QObject *parent = nullptr);
+    ~AnalysisScheduler();
+
+    void start(QByteArray file_data, int sample_rate, qint16 track_num, qreal length_sec);
+    void start_all(QByteArray file_data, int sample_rate, QMap<qint16, qreal> track_lengths_sec);
+    void cancel();
+    void cancel_all();
+
+signals:
+    void progressChanged(qreal progress);
+    void tonesFound(int channel_i, QVector<ToneObject> tones);
+    // Ownership of analysis.emu passes to the receiver.
+    void finished(TrackAnalysis analysis);
+    void failed(QString error);
+    // A background job is done. Ownership of analysis.emu passes to the receiver.
+    void trackAnalysed(TrackAnalysis analysis);
+
+private slots:
+    void handleProgress(quint64 job_id, qreal progress);
+    void handleTones(quint64 job_id, int channel_i, QVector<ToneObject> tones);
+    void handleFinished(quint64 job_id, TrackAnalysis analysis);
+    void handleFailed(quint64 job_id, QString error);
+
+private:
+    void submit(AnalysisJob *job, int priority);
+
+    QThreadPool pool;
+    quint64 next_job_id = 1;
+    QSharedPointer<QAtomicInt> cancelled;
+    quint64 job_id = 0;
+    bool running = false;
+    QSharedPointer<QAtomicInt> batch_cancelled;
+    quint64 batch_id = 0;
+    int batch_remain = 0;
+};
+
+#endif // ANALYSISSCHEDULER_H
@@ -0,0 +1,82 @@
+#include "archiveblockreader.h"
+
+#include <QDebug>
+
+#include <archive.h>
+
+ArchiveBlockReader::ArchiveBlockReader(struct archive *archive, std::streamsize block_size,
+                                       int block_count, int headroom)
+    : archive(archive), block_size(block_size), headroom(headroom)
+{
+    for (int block_i = 0; block_i < block_count; block_i += 1) {
+        this->blocks.append(new char[headroom + block_size]);
+        this->block_bytes.append(0);
+    }
+    this->start();
+}
+
+ArchiveBlockReader::~ArchiveBlockReader() {
+    this->mutex.lock();
+    this->stopping = true;
+    this->block_freed.wakeAll();
+    this->mutex.unlock();
+    this->wait();
+    for (char *block: this->blocks) {
+        delete[] block;
+    }
+}
+
+void ArchiveBlockReader::run() {
+    const int block_count = this->blocks.size();
+    int write_i = 0;
+    while (true) {
+        this->mutex.lock();
+        // A block is free unless it's waiting for the caller or the caller still holds it.
+        while (!this->stopping && this->filled + (this->holding ? 1 : 0) >= block_count) {
+            this->block_freed.wait(&this->mutex);
+        }
+        bool stopping = this->stopping;
+        this->mutex.unlock();
+        if (stopping) {
+            return;
+        }
+
+        std::streamsize bytes_read = archive_read_data(this->archive, this->blocks[write_i] + this->headroom, this->block_size);
+        if (bytes_read < 0) {
+            qDebug() << archive_error_string(this->archive);
+            bytes_read = 0;
+        }
+
+        this->mutex.lock();
+        this->block_bytes[write_i] = bytes_read;
+        this->filled += 1;
+        this->block_filled.wakeAll();
+        this->mutex.unlock();
+        if (bytes_read == 0) {
+            return;
+        }
+        write_i = (write_i + 1) % block_count;
+    }
+}
+
+std::streamsize ArchiveBlockReader::next_block(char *&data) {
+    QMutexLocker locker(&this->mutex);
+    if (this->holding) {
+        this->holding = false;
+        this->block_freed.wakeAll();
+    }
+    while (!this->filled) {
+        this->block_filled.wait(&this->mutex);
+    }
+    std::streamsize bytes = this->block_bytes[this->read_i];
+    if (bytes == 0) {
+        // Leave the end marker in place, so later calls also return 0.
+        data = nullptr;
+        return 0;
+    }
+    data = this->blocks[this->read_i] + this->headroom;
+    this->filled -= 1;
+    this->holding = true;
+    this->read_i = (this->read_i + 1) % this->blocks.size();
+    return bytes;
+}
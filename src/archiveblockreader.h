@@ -0,0 +1,47 @@
+#ifndef ARCHIVEBLOCKREADER_H
+#define ARCHIVEBLOCKREADER_H
+
+#include <ios>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+struct archive;
+
+// Decompresses an archive entry on its own thread into a ring of reusable
+// blocks, so the caller can work on one block while the following ones are
+// being decompressed.
+class ArchiveBlockReader : public QThread
+{
+public:
+    // Every block has 'headroom' spare bytes in front of its data, which the
+    // caller may use to prepend leftovers from the previous block.
+    ArchiveBlockReader(struct archive *archive, std::streamsize block_size,
+                       int block_count = 4, int headroom = 0);
+    ~ArchiveBlockReader();
+
+    // Hands the previous block back for reuse, then waits for the next one.
+    // Returns the number of bytes at 'data', or 0 once the entry is exhausted.
+    std::streamsize next_block(char *&data);
+
+protected:
+    void run() override;
+
+private:
+    struct archive *archive;
+    const std::streamsize block_size;
+    const int headroom;
+    QVector<char*> blocks;
+    QVector<std::streamsize> block_bytes;
+
+    QMutex mutex;
+    QWaitCondition block_filled;
+    QWaitCondition block_freed;
+    int filled = 0; // blocks waiting for the caller
+    int read_i = 0; // next block handed to the caller
+    bool holding = false; // the caller holds the block before read_i
+    bool stopping = false;
+};
+
+#endif // ARCHIVEBLOCKREADER_H
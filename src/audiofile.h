@@ -4,25 +4,8 @@
 #include <ios>
 #include <QObject>
 
-#include "squarechannel.h"
-#include "trianglechannel.h"
 #include "toneobject.h"
-
-struct WAVheader {
-    char RIFF_literal[4];
-    uint32_t chunk_size;
-    char WAVE_literal[4];
-    char fmt__literal[4];
-    uint32_t subchunk1_size;
-    uint16_t audio_format;
-    uint16_t num_channels;
-    uint32_t sample_rate;
-    uint32_t byte_rate;
-    uint16_t block_align;
-    uint16_t bits_per_sample;
-    char data_literal[4];
-    uint32_t subchunk2_size;
-};
+#include "wavanalysis.h"
 
 class ChannelModel;
 
@@ -39,11 +22,8 @@ public:
     explicit AudioFile(QObject *parent = 0);
 
     void open(QString file_name);
-    void read_block(char block[], std::streamsize &bytes_read);
     void close();
-    void read_runs();
-    void process_runs();
-    void determine_range(QVector<ToneObject> &tones);
+    void determine_range(const QVector<ToneObject> &tones);
 
 public slots:
     void openClicked();
@@ -54,7 +34,7 @@ signals:
     void channel2Changed(ChannelModel *channel2);
     void lowestToneChanged(int lowest_tone);
     void highestToneChanged(int highest_tone);
-    void channelRunsChanged(QList<QList<Run>> channel_runs);
+    void channelRunsChanged(QVector<RunBuffer> channel_runs);
 
 protected:
     QString file_types { "Compressed WAV (*.wav.gz *.wav.xz)" };
@@ -66,10 +46,9 @@ protected:
     int highest_tone;
 
 private:
-    struct archive *m_archive;
-    QList<QList<Run>> channel_runs;
-    SquareChannel square_channels[2];
-    TriangleChannel triangle_channel;
+    void show_tones();
+
+    WavAnalysis wav;
 };
 
 /*
@@ -7,14 +7,120 @@ ChannelModel::ChannelModel(QObject *parent)
 }
 
 ChannelModel::ChannelModel(const QVector<ToneObject> tones, QObject *parent)
-    : QAbstractListModel(parent), tones(tones)
+    : QAbstractListModel(parent)
 {
+    this->set_tones(tones);
+}
+
+ToneRow ChannelModel::tone_row(const ToneObject &tone) {
+    return { tone.semitone_id, tone.start, tone.length, tone.nes_timer, tone.nes_timer_end, tone.shape, tone.volume };
+}
+
+QVector<ToneRow> ChannelModel::tone_rows(const QVector<ToneObject> &tones) {
+    QVector<ToneRow> rows;
+    rows.reserve(tones.size());
+    for (const ToneObject &tone: tones) {
+        rows.append(tone_row(tone));
+    }
+    return rows;
 }
 
 void ChannelModel::set_tones(QVector<ToneObject> tones) {
-    this->beginResetModel();
-    this->tones = tones;
-    this->endResetModel();
+    this->replace_rows(0, this->tones.size(), tone_rows(tones));
+}
+
+void ChannelModel::append_tones(const QVector<ToneObject> &tones) {
+    if (tones.isEmpty()) {
+        return;
+    }
+    int first = this->tones.size();
+    this->beginInsertRows(QModelIndex(), first, first + tones.size() - 1);
+    for (const ToneObject &tone: tones) {
+        this->tones.append(tone_row(tone));
+    }
+    this->names.resize(this->tones.size());
+    this->pyramid_dirty = true;
+    this->endInsertRows();
+}
+
+void ChannelModel::update_tones(int first, const QVector<ToneObject> &tones) {
+    first = qMin(first, this->tones.size());
+    int last = qMin(first + tones.size(), this->tones.size());
+    this->replace_rows(first, last, tone_rows(tones));
+}
+
+void ChannelModel::truncate(int row_count) {
+    if (row_count >= this->tones.size()) {
+        return;
+    }
+    this->replace_rows(row_count, this->tones.size(), {});
+}
+
+// Replaces rows [first, last) with 'rows'. Rows that match at either end of
+// the range are left alone, the rest are changed in place as far as they
+// overlap, and only the difference in length is inserted or removed.
+void ChannelModel::replace_rows(int first, int last, const QVector<ToneRow> &rows) {
+    this->pyramid_dirty = true;
+    int old_count = last - first;
+    int new_count = rows.size();
+    int prefix = 0;
+    while (prefix < old_count && prefix < new_count && this->tones[first + prefix] == rows[prefix]) {
+        prefix += 1;
+    }
+    int suffix = 0;
+    while (suffix < old_count - prefix && suffix < new_count - prefix
+           && this->tones[last - 1 - suffix] == rows[new_count - 1 - suffix]) {
+        suffix += 1;
+    }
+    int overlap = qMin(old_count, new_count) - prefix - suffix;
+    int changed_first = -1;
+    for (int i = prefix; i < prefix + overlap; i += 1) {
+        int row = first + i;
+        if (this->tones[row] == rows[i]) {
+            if (changed_first >= 0) {
+                this->rows_changed(changed_first, row - 1);
+                changed_first = -1;
+            }
+            continue;
+        }
+        this->tones[row] = rows[i];
+        this->names[row] = QString();
+        if (changed_first < 0) {
+            changed_first = row;
+        }
+    }
+    if (changed_first >= 0) {
+        this->rows_changed(changed_first, first + prefix + overlap - 1);
+    }
+    int gap_row = first + prefix + overlap;
+    if (new_count > old_count) {
+        int inserted = new_count - old_count;
+        this->beginInsertRows(QModelIndex(), gap_row, gap_row + inserted - 1);
+        this->tones.insert(gap_row, inserted, ToneRow {});
+        this->names.insert(gap_row, inserted, QString());
+        for (int i = 0; i < inserted; i += 1) {
+            this->tones[gap_row + i] = rows[prefix + overlap + i];
+        }
+        this->endInsertRows();
+    } else if (old_count > new_count) {
+        int removed = old_count - new_count;
+        this->beginRemoveRows(QModelIndex(), gap_row, gap_row + removed - 1);
+        this->tones.remove(gap_row, removed);
+        this->names.remove(gap_row, removed);
+        this->endRemoveRows();
+    }
+}
+
+const TonePyramid &ChannelModel::pyramid() const {
+    if (this->pyramid_dirty) {
+        this->tone_pyramid.build(this->tones);
+        this->pyramid_dirty = false;
+    }
+    return this->tone_pyramid;
+}
+
+void ChannelModel::rows_changed(int first, int last) {
+    emit this->dataChanged(this->index(first), this->index(last));
 }
 
 int ChannelModel::rowCount(const QModelIndex &parent) const
@@ -28,15 +134,15 @@ int ChannelModel::rowCount(const QModelIndex &parent) const
 }
 
 QVariant ChannelModel::data(const QModelIndex &index, int role) const {
-    if (!index.isValid() || index.row() > this->rowCount())
+    if (!index.isValid() || index.row() >= this->rowCount())
         return QVariant();
-    const ToneObject tone = this->tones.at(index.row());
+    const ToneRow &tone = this->tones.at(index.row());
     switch (role) {
         case SemiToneIdRole:
             return QVariant(tone.semitone_id);
         break;
         case SemiToneIdEndRole:
-            return QVariant(tone.semitone_id_end());
+            return QVariant(semitone_id_end(tone.semitone_id, tone.nes_timer_end));
         break;
         case NesTimerRole:
             return QVariant(tone.nes_timer);
@@ -56,28 +162,49 @@ QVariant ChannelModel::data(const QModelIndex &index, int role) const {
         case VolumeRole:
             return QVariant((qint64)tone.volume);
         break;
-        case NameRole:
-            return QVariant(tone.name());
+        case NameRole: {
+            QString &name = this->names[index.row()];
+            if (name.isNull()) {
+                name = semitone_name(tone.semitone_id);
+            }
+            return QVariant(name);
+        }
         break;
     }
     return QVariant();
 }
 
+QVariantMap ChannelModel::get(int row) const {
+    QVariantMap roles;
+    if (row < 0 || row >= this->rowCount()) {
+        return roles;
+    }
+    QModelIndex index = this->index(row);
+    QHash<int, QByteArray> role_names = this->roleNames();
+    for (auto role = role_names.constBegin(); role != role_names.constEnd(); ++role) {
+        roles[QString::fromUtf8(role.value())] = this->data(index, role.key());
+    }
+    return roles;
+}
+
 Qt::ItemFlags ChannelModel::flags(const QModelIndex &index) const {
-    if (!index.isValid() || index.row() > this->rowCount())
+    if (!index.isValid() || index.row() >= this->rowCount())
         return Qt::NoItemFlags;
     return Qt::ItemIsEnabled | Qt::ItemIsEditable;
 }
 
 bool ChannelModel::setData(const QModelIndex &index, const QVariant &value, int role) {
-    if (!index.isValid() || index.row() > this->rowCount())
+    if (!index.isValid() || index.row() >= this->rowCount())
         return false;
-    ToneObject *tone = &this->tones[index.row()];
+    ToneRow *tone = &this->tones[index.row()];
     bool changed { false };
     switch (role) {
         case SemiToneIdRole:
             changed = (tone->semitone_id != value.toDouble());
             tone->semitone_id = value.toDouble();
+            if (changed) {
+                this->names[index.row()] = QString();
+            }
         break;
         case NesTimerRole:
             changed = (tone->nes_timer != value.toInt());
@@ -100,7 +227,10 @@ bool ChannelModel::setData(const QModelIndex &index, const QVariant &value, int
             tone->volume = value.toInt();
         break;
     }
-    if (changed) emit dataChanged(index, index, {role});
+    if (changed) {
+        this->pyramid_dirty = true;
+        emit dataChanged(index, index, {role});
+    }
     return true;
 }
 
@@ -4,6 +4,24 @@
 #include <QAbstractListModel>
 
 #include "toneobject.h"
+#include "tonepyramid.h"
+
+// What the model shows of a tone. Cycles are left out, so rows are plain data.
+struct ToneRow {
+    double semitone_id;
+    sampleoff start;
+    samplesize length;
+    qint16 nes_timer;
+    qint16 nes_timer_end;
+    short int shape;
+    samplevalue volume;
+};
+
+inline bool operator==(const ToneRow &a, const ToneRow &b) {
+    return a.semitone_id == b.semitone_id && a.start == b.start && a.length == b.length
+        && a.nes_timer == b.nes_timer && a.nes_timer_end == b.nes_timer_end
+        && a.shape == b.shape && a.volume == b.volume;
+}
 
 class ChannelModel : public QAbstractListModel
 {
@@ -13,7 +31,19 @@ public:
     explicit ChannelModel(QObject *parent = nullptr);
     explicit ChannelModel(const QVector<ToneObject> tones, QObject *parent = nullptr);
 
+    // These only touch the rows that change, so views keep the delegates of
+    // every other row instead of rebuilding them all.
     void set_tones(QVector<ToneObject> tones);
+    void append_tones(const QVector<ToneObject> &tones);
+    // Replaces the rows from row 'first' on, up to as many rows as there are tones.
+    void update_tones(int first, const QVector<ToneObject> &tones);
+    // Removes every row from row 'row_count' on.
+    void truncate(int row_count);
+    const QVector<ToneRow> &rows() const { return this->tones; }
+    // Rebuilt the first time it's needed after the rows change.
+    const TonePyramid &pyramid() const;
+    // Every role of one row, by role name.
+    Q_INVOKABLE QVariantMap get(int row) const;
 
     enum ModelRoles {
         SemiToneIdRole = Qt::UserRole +1,
@@ -36,7 +66,16 @@ public:
 
     QHash<int, QByteArray> roleNames() const override;
 private:
-    QVector<ToneObject> tones;
+    static ToneRow tone_row(const ToneObject &tone);
+    static QVector<ToneRow> tone_rows(const QVector<ToneObject> &tones);
+    void replace_rows(int first, int last, const QVector<ToneRow> &rows);
+    void rows_changed(int first, int last);
+
+    QVector<ToneRow> tones;
+    // Formatted as they're first asked for. A null string hasn't been formatted yet.
+    mutable QVector<QString> names;
+    mutable TonePyramid tone_pyramid;
+    mutable bool pyramid_dirty = true;
 };
 
 #endif // CHANNELMODEL_H
@@ -0,0 +1,118 @@
+#include "emuproducer.h"
+
+#include <QDebug>
+
+#include "gme/gme.h"
+
+// Samples emulated at a time, counting both stereo channels.
+const int CHUNK_SAMPLES = 1024;
+// Commands waiting for the thread. Senders wait if it's ever full.
+const int COMMAND_CAPACITY = 64;
+
+EmuProducer::EmuProducer(int capacity)
+    : ring(capacity), commands(COMMAND_CAPACITY)
+{
+}
+
+EmuProducer::~EmuProducer() {
+    this->stop();
+}
+
+void EmuProducer::start_emu(Music_Emu *emu) {
+    this->stop();
+    this->emu = emu;
+    gme_mute_voices(this->emu, this->muted_voices);
+    // Whatever is left in the ring came from the previous emulator.
+    this->ring.discard_until(this->ring.written());
+    this->stopping.storeRelease(0);
+    this->start();
+}
+
+void EmuProducer::stop() {
+    this->stopping.storeRelease(1);
+    this->wait();
+    // Commands the thread didn't get to are applied here, now that it's stopped.
+    Command command;
+    while (this->commands.read(&command, 1)) {
+        this->handle(command);
+    }
+    this->emu = nullptr;
+}
+
+void EmuProducer::set_capacity(int capacity) {
+    this->stop();
+    this->ring.resize(capacity);
+}
+
+int EmuProducer::read(short *samples, int count) {
+    int done = this->seeks_done.loadAcquire();
+    if (done != this->seeks_sent) {
+        return 0;
+    }
+    if (done != this->seeks_applied) {
+        this->ring.discard_until(this->seek_start.loadAcquire());
+        this->seeks_applied = done;
+    }
+    return this->ring.read(samples, count);
+}
+
+void EmuProducer::seek_samples(qint64 sample_position) {
+    this->seeks_sent += 1;
+    this->send({ Command::Seek, sample_position, 0, this->seeks_sent });
+}
+
+void EmuProducer::mute_voice(int voice_i, int muted) {
+    this->send({ Command::Mute, muted, voice_i, 0 });
+}
+
+void EmuProducer::send(const Command &command) {
+    if (!this->isRunning()) {
+        this->handle(command);
+        return;
+    }
+    while (!this->commands.write(&command, 1)) {
+        QThread::yieldCurrentThread();
+    }
+}
+
+void EmuProducer::handle(const Command &command) {
+    switch (command.type) {
+        case Command::Seek:
+            if (this->emu) {
+                gme_seek_samples(this->emu, command.value);
+            }
+            this->seek_start.storeRelease(this->ring.written());
+            this->seeks_done.storeRelease(command.seek_id);
+        break;
+        case Command::Mute:
+            if (command.value) {
+                this->muted_voices |= 1 << command.voice_i;
+            } else {
+                this->muted_voices &= ~(1 << command.voice_i);
+            }
+            if (this->emu) {
+                gme_mute_voice(this->emu, command.voice_i, command.value);
+            }
+        break;
+    }
+}
+
+void EmuProducer::run() {
+    short chunk[CHUNK_SAMPLES];
+    while (!this->stopping.loadAcquire()) {
+        Command command;
+        while (this->commands.read(&command, 1)) {
+            this->handle(command);
+        }
+        if (this->ring.writable() < CHUNK_SAMPLES) {
+            // The output is far enough behind. It reads about a period at a time.
+            QThread::msleep(1);
+            continue;
+        }
+        gme_err_t err = gme_play(this->emu, CHUNK_SAMPLES, chunk);
+        if (err) {
+            qDebug() << err;
+        }
+        this->ring.write(chunk, CHUNK_SAMPLES);
+    }
+}
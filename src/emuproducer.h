@@ -0,0 +1,68 @@
+#ifndef EMUPRODUCER_H
+#define EMUPRODUCER_H
+
+#include <QAtomicInt>
+#include <QThread>
+
+#include "spscring.h"
+
+class Music_Emu;
+
+// Plays an emulator on its own thread, ahead of the audio output, into a
+// lock-free ring the output copies from. Seeks and mutes are sent to the
+// thread through a second lock-free ring, so neither side ever waits for
+// the other. Everything but run() is called from the reading thread.
+class EmuProducer : public QThread
+{
+public:
+    // 'capacity' is in samples, counting each stereo channel separately.
+    explicit EmuProducer(int capacity);
+    ~EmuProducer();
+
+    // Starts playing 'emu' from wherever it is, with the voices muted so
+    // far. It must not be touched elsewhere until stop() has returned.
+    void start_emu(Music_Emu *emu);
+    void stop();
+    // Stops the thread, and empties the ring.
+    void set_capacity(int capacity);
+
+    // Copies up to 'count' samples out of the ring, and returns how many
+    // there were. Returns 0 while a seek is on its way to the emulator, so
+    // samples from before the seek are never read.
+    int read(short *samples, int count);
+    void seek_samples(qint64 sample_position);
+    void mute_voice(int voice_i, int muted);
+
+protected:
+    void run() override;
+
+private:
+    struct Command {
+        enum Type {
+            Seek,
+            Mute
+        } type;
+        qint64 value;
+        int voice_i;
+        int seek_id;
+    };
+
+    void send(const Command &command);
+    void handle(const Command &command);
+
+    Music_Emu *emu = nullptr;
+    SpscRing<short> ring;
+    SpscRing<Command> commands;
+    QAtomicInt stopping { 0 };
+    // Mutes are kept while no emulator is playing, for the next one.
+    int muted_voices = 0;
+
+    // Seeks are numbered. Once the emulator has seeked, the thread stores
+    // where in the ring the seeked samples start, then the seek's number.
+    int seeks_sent = 0;
+    int seeks_applied = 0;
+    QAtomicInt seeks_done { 0 };
+    QAtomicInteger<quint64> seek_start { 0 };
+};
+
+#endif // EMUPRODUCER_H
@@ -5,26 +5,52 @@
 #include "generator.h"
 #include "toneobject.h"
 
+#include "gme/nes_mixer.h"
+
 extern "C" {
     #include "soxr.h"
 }
 
+const size_t BUFFER_ALIGNMENT = 64;
+
 Generator::Generator(const int output_rate)
     : output_rate(output_rate)
 {
     this->sample_rate_ratio = static_cast<double>(this->internal_rate) / this->output_rate;
     for (uint8_t channel_i = 0; channel_i < 5; channel_i += 1) {
-        this->channels[channel_i] = { QList<Run> {}, 0, 0, nullptr, false };
+        this->channels[channel_i] = { RunBuffer {}, RunBuffer::const_iterator {}, 0, nullptr, false };
+        this->channels[channel_i].run_i = this->channels[channel_i].runs.begin();
     }
     this->init_soxr();
+    // A tenth of a second, until the audio output says how much it reads at a time.
+    this->set_chunk_size(this->output_rate / 10);
 }
 
 Generator::~Generator() {
-    delete[] downsampled_buffer;
-    delete[] mixed_buffer;
+    qFreeAligned(this->arena);
     soxr_delete(this->soxr);
 }
 
+// Every buffer is carved out of one arena, each starting on its own cache line.
+void Generator::set_chunk_size(qint64 output_samples) {
+    if (output_samples <= 0 || output_samples == this->chunk_samples) {
+        return;
+    }
+    auto aligned = [](size_t size) { return (size + BUFFER_ALIGNMENT - 1) / BUFFER_ALIGNMENT * BUFFER_ALIGNMENT; };
+    // Rounding the number of APU samples in a chunk can add one.
+    qint64 internal_samples = std::ceil(output_samples * this->sample_rate_ratio * this->resolution_multiplier) + 1;
+    size_t channel_bytes = aligned(internal_samples * sizeof(samplevalue));
+    size_t mixed_bytes = aligned(internal_samples * sizeof(float));
+    qFreeAligned(this->arena);
+    this->arena = static_cast<char*>(qMallocAligned(5 * channel_bytes + mixed_bytes, BUFFER_ALIGNMENT));
+    for (uint8_t channel_i = 0; channel_i < 5; channel_i += 1) {
+        this->channels[channel_i].buffer = reinterpret_cast<samplevalue*>(this->arena + channel_i * channel_bytes);
+    }
+    this->mixed_buffer = reinterpret_cast<float*>(this->arena + 5 * channel_bytes);
+    this->chunk_samples = output_samples;
+    this->step_synth.reserve(output_samples);
+}
+
 void Generator::init_soxr() {
     const soxr_datatype_t itype = static_cast<soxr_datatype_t>(0);
     const soxr_datatype_t otype = static_cast<soxr_datatype_t>(0);
@@ -38,71 +64,83 @@ void Generator::init_soxr() {
     this->soxr = soxr_create(this->internal_rate * this->resolution_multiplier, this->output_rate, 1, &error, &io_spec, &quality_spec, &runtime_spec);
 }
 
-void Generator::setChannels(QList<QList<Run>> channel_runs) {
+void Generator::setChannels(const QVector<RunBuffer> &channel_runs) {
     for (uint8_t channel_i = 0; channel_i < 5; channel_i += 1) {
         this->channels[channel_i].runs = channel_runs[channel_i];
-        this->channels[channel_i].runs_i = 0;
-        this->channels[channel_i].runs_i_sample = 0;
-        delete[] this->channels[channel_i].buffer;
-        this->channels[channel_i].buffer = nullptr;
+        this->channels[channel_i].run_i = this->channels[channel_i].runs.begin();
+        this->channels[channel_i].run_i_sample = 0;
     }
     soxr_clear(this->soxr);
+    this->clock = 0;
+    this->frame_start = 0;
+    this->level = 0;
+    this->step_synth.clear();
 }
 
 void Generator::toggle_mute(uint8_t channel_i) {
     this->channels[channel_i].muted = !this->channels[channel_i].muted;
 }
 
+void Generator::set_render_mode(RenderMode mode) {
+    this->render_mode = mode;
+    soxr_clear(this->soxr);
+    this->frame_start = this->clock;
+    this->level = 0;
+    this->step_synth.clear();
+}
+
 qint64 Generator::render_runs(Channel &channel, qint64 output_samples_requested) {
     qint64 rendered_samples = 0;
     // TODO: I'm not sure what to do about the noninteger number of samples needed.
     qint64 internal_samples_needed = std::round(output_samples_requested * this->sample_rate_ratio);
-    if (channel.buffer == nullptr) {
-        qint64 buffer_size = internal_samples_needed * this->resolution_multiplier;
-        channel.buffer = new samplevalue[buffer_size];
-    }
-    while (channel.runs_i < channel.runs.size() && rendered_samples < internal_samples_needed) {
-        Run run = channel.runs.at(channel.runs_i);
-        qint64 remaining_run_samples = run.length - channel.runs_i_sample;
+    while (channel.run_i != channel.runs.end() && rendered_samples < internal_samples_needed) {
+        Run run = *channel.run_i;
+        qint64 remaining_run_samples = run.length - channel.run_i_sample;
         qint64 capped_samples = remaining_run_samples;
         if (rendered_samples + remaining_run_samples > internal_samples_needed) {
             capped_samples = internal_samples_needed - rendered_samples;
         }
-        channel.runs_i_sample += capped_samples;
+        channel.run_i_sample += capped_samples;
         samplevalue *buffer_offset = channel.buffer + static_cast<qint64>(rendered_samples * this->resolution_multiplier);
         samplevalue buffer_value = channel.muted ? 0 : run.value;
         qint64 buffer_samples = capped_samples * this->resolution_multiplier;
         memset(buffer_offset, buffer_value, buffer_samples);
         rendered_samples += capped_samples;
-        if (channel.runs_i_sample >= run.length) {
-            channel.runs_i += 1;
-            channel.runs_i_sample = 0;
+        if (channel.run_i_sample >= run.length) {
+            ++channel.run_i;
+            channel.run_i_sample = 0;
         }
     }
     return rendered_samples * resolution_multiplier;
 }
 
+// Mixes a block at a time: first the table indices for every sample, in
+// loops over plain bytes the compiler can vectorize, then the lookups.
 void Generator::mix_channels(qint64 size) {
-    for (qint64 sample_i = 0; sample_i < size; sample_i += 1) {
-        float pulse_out = 0;
-        samplevalue pulse_sum = channels[0].buffer[sample_i] + channels[1].buffer[sample_i];
-        if (pulse_sum > 0) {
-            pulse_out = 95.88 / (8128.0 / pulse_sum + 100.0);
+    const qint64 BLOCK = 256;
+    uint8_t pulse_i[BLOCK];
+    uint8_t tnd_i[BLOCK];
+    for (qint64 block_start = 0; block_start < size; block_start += BLOCK) {
+        const qint64 block_size = std::min(BLOCK, size - block_start);
+        const samplevalue *square1 = this->channels[0].buffer + block_start;
+        const samplevalue *square2 = this->channels[1].buffer + block_start;
+        const samplevalue *triangle = this->channels[2].buffer + block_start;
+        const samplevalue *noise = this->channels[3].buffer + block_start;
+        const samplevalue *dmc = this->channels[4].buffer + block_start;
+        for (qint64 sample_i = 0; sample_i < block_size; sample_i += 1) {
+            pulse_i[sample_i] = square1[sample_i] + square2[sample_i];
+            tnd_i[sample_i] = 3 * triangle[sample_i] + 2 * noise[sample_i] + dmc[sample_i];
         }
-        float tnd_out = 0;
-        samplevalue tnd_sum = channels[2].buffer[sample_i] + channels[3].buffer[sample_i] + channels[4].buffer[sample_i];
-        if (tnd_sum > 0) {
-            tnd_out = 159.79 / (1 / (
-                channels[2].buffer[sample_i] / 8227.0 +
-                channels[3].buffer[sample_i] / 12241.0 +
-                channels[4].buffer[sample_i] / 22638.0) + 100);
+        float *mixed = this->mixed_buffer + block_start;
+        for (qint64 sample_i = 0; sample_i < block_size; sample_i += 1) {
+            mixed[sample_i] = nes_pulse_table[pulse_i[sample_i]] + nes_tnd_table[tnd_i[sample_i]];
         }
-        this->mixed_buffer[sample_i] = pulse_out + tnd_out;
     }
 }
 
-size_t Generator::resample_soxr(float out[], size_t in_size) {
+size_t Generator::resample_soxr(float out[], size_t in_size, size_t out_capacity) {
     size_t out_size = std::round(in_size / this->sample_rate_ratio / this->resolution_multiplier);
+    out_size = std::min(out_size, out_capacity);
     size_t idone, odone;
     soxr_error_t error = soxr_process(this->soxr,
         this->mixed_buffer, in_size, &idone,
@@ -113,43 +151,118 @@ size_t Generator::resample_soxr(float out[], size_t in_size) {
     return odone;
 }
 
-bool Generator::seek_sample(qint64 sample_position) {
+float Generator::mix_level() const {
+    samplevalue values[5];
     for (uint8_t channel_i = 0; channel_i < 5; channel_i += 1) {
-        qint64 running_total = 0;
-        qint64 i = 0;
-        for(Run &run: this->channels[channel_i].runs) {
-            if (running_total + run.length >= sample_position) {
-                break;
+        const Channel &channel = this->channels[channel_i];
+        bool sounding = !channel.muted && channel.run_i != channel.runs.end();
+        values[channel_i] = sounding ? channel.run_i->value : 0;
+    }
+    return nes_mix(values[0], values[1], values[2], values[3], values[4]);
+}
+
+// Channels only change value where a run ends, so the mix is only worked
+// out there and handed to the step synth as a step, at its fraction of an
+// output sample. Nothing is rendered at the APU rate.
+qint64 Generator::render_steps(float out[], qint64 output_samples) {
+    bool ended = true;
+    for (const Channel &channel: this->channels) {
+        ended = ended && channel.run_i == channel.runs.end();
+    }
+    if (ended && this->level == 0) {
+        return 0;
+    }
+    double frame_end = this->frame_start + output_samples * this->sample_rate_ratio;
+    // Mutes toggled since the last frame take effect at its start.
+    float level = this->mix_level();
+    if (level != this->level) {
+        this->step_synth.add_step(0, level - this->level);
+        this->level = level;
+    }
+    while (true) {
+        // How far it is to the next run that ends, on any channel.
+        qint64 next = -1;
+        for (const Channel &channel: this->channels) {
+            if (channel.run_i != channel.runs.end()) {
+                qint64 remaining = channel.run_i->length - channel.run_i_sample;
+                if (next < 0 || remaining < next) {
+                    next = remaining;
+                }
+            }
+        }
+        if (next < 0 || this->clock + next >= frame_end) {
+            break;
+        }
+        this->clock += next;
+        for (Channel &channel: this->channels) {
+            if (channel.run_i == channel.runs.end()) {
+                continue;
+            }
+            channel.run_i_sample += next;
+            if (channel.run_i_sample >= channel.run_i->length) {
+                ++channel.run_i;
+                channel.run_i_sample = 0;
             }
-            running_total += run.length;
-            i += 1;
         }
-        this->channels[channel_i].runs_i = i;
-        this->channels[channel_i].runs_i_sample = sample_position - running_total;
+        level = this->mix_level();
+        if (level != this->level) {
+            double time = (this->clock - this->frame_start) / this->sample_rate_ratio;
+            this->step_synth.add_step(time, level - this->level);
+            this->level = level;
+        }
+    }
+    this->step_synth.read_samples(out, output_samples);
+    this->frame_start = frame_end;
+    return output_samples;
+}
+
+bool Generator::seek_sample(qint64 sample_position) {
+    for (uint8_t channel_i = 0; channel_i < 5; channel_i += 1) {
+        Channel &channel = this->channels[channel_i];
+        channel.run_i = channel.runs.iterator_at_sample(sample_position);
+        channel.run_i_sample = 0;
+        if (channel.run_i != channel.runs.end()) {
+            channel.run_i_sample = std::max<qint64>(sample_position - channel.run_i->start, 0);
+        }
     }
+    this->clock = sample_position;
+    this->frame_start = sample_position;
+    this->level = 0;
+    this->step_synth.clear();
     qint64 byte_position = sample_position / this->sample_rate_ratio * sizeof(float);
     this->seek(byte_position);
     return true;
 }
 
-qint64 Generator::readData(char *data, qint64 maxSize) {
-    qint64 output_samples_requested = maxSize / sizeof(float);
+// Renders at most one chunk, so it fits in the buffers.
+qint64 Generator::render_chunk(float out[], qint64 output_samples) {
+    if (this->render_mode == Steps) {
+        return this->render_steps(out, output_samples);
+    }
     qint64 internal_samples_generated = 0;
     for (Channel &channel: this->channels) {
-        internal_samples_generated = this->render_runs(channel, output_samples_requested);
+        internal_samples_generated = this->render_runs(channel, output_samples);
         // TODO: Should probably check to make sure all the sizes are the same.
     }
-    if (this->mixed_buffer == nullptr) {
-        this->mixed_buffer = new float[internal_samples_generated];
-    }
+    this->clock += internal_samples_generated / this->resolution_multiplier;
     this->mix_channels(internal_samples_generated);
-    if (this->downsampled_buffer == nullptr) {
-        this->downsampled_buffer = new float[output_samples_requested];
+    return this->resample_soxr(out, internal_samples_generated, output_samples);
+}
+
+qint64 Generator::readData(char *data, qint64 maxSize) {
+    float *out = reinterpret_cast<float*>(data);
+    qint64 output_samples_requested = maxSize / sizeof(float);
+    qint64 output_samples = 0;
+    while (output_samples < output_samples_requested) {
+        qint64 chunk = std::min(this->chunk_samples, output_samples_requested - output_samples);
+        qint64 rendered = this->render_chunk(out + output_samples, chunk);
+        output_samples += rendered;
+        if (rendered < chunk) {
+            break;
+        }
     }
-    size_t bytes = sizeof(float) * this->resample_soxr(downsampled_buffer, internal_samples_generated);
-    memcpy(data, downsampled_buffer, bytes);
     emit this->positionChanged(this->pos());
-    return bytes;
+    return output_samples * sizeof(float);
 }
 
 qint64 Generator::writeData(const char *data, qint64 len)
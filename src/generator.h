@@ -4,12 +4,13 @@
 #include <QIODevice>
 #include <QVector>
 #include "soxr.h"
+#include "stepsynth.h"
 #include "toneobject.h"
 
 struct Channel {
-    QList<Run> runs;
-    qint64 runs_i;
-    qint64 runs_i_sample;
+    RunBuffer runs;
+    RunBuffer::const_iterator run_i;
+    qint64 run_i_sample;
     samplevalue *buffer;
     bool muted;
 };
@@ -21,15 +22,29 @@ class Generator : public QIODevice
     Q_OBJECT
 
 public:
+    // How readData turns runs into samples.
+    enum RenderMode {
+        // Expands every run to the APU rate, mixes each sample and resamples with soxr.
+        Resampled,
+        // Mixes only where some channel's run changes, and synthesizes the
+        // steps between mixes straight at the output rate.
+        Steps
+    };
+
     Generator(const int output_rate);
     ~Generator();
 
     void init_soxr();
-    void setChannels(QList<QList<Run>> channel_runs);
+    // Sizes the buffers for 'output_samples' at a time. Longer reads are
+    // rendered a chunk at a time, so reading never allocates.
+    void set_chunk_size(qint64 output_samples);
+    void setChannels(const QVector<RunBuffer> &channel_runs);
     void toggle_mute(uint8_t channel_i);
+    void set_render_mode(RenderMode mode);
     qint64 render_runs(Channel &channel, qint64 maxSize);
     void mix_channels(qint64 size);
-    size_t resample_soxr(float out[], size_t in_size);
+    size_t resample_soxr(float out[], size_t in_size, size_t out_capacity);
+    qint64 render_steps(float out[], qint64 output_samples);
 
     bool seek_sample(qint64 sample_position);
     qint64 readData(char *data, qint64 maxlen) override;
@@ -39,14 +54,27 @@ signals:
     void positionChanged(qint64 byte_position);
 
 private:
+    float mix_level() const;
+    qint64 render_chunk(float out[], qint64 output_samples);
+
+    RenderMode render_mode = Steps;
     int internal_rate = 1789773;
     qreal resolution_multiplier = 1;
     int output_rate;
     qreal sample_rate_ratio;
     Channel channels[5];
+    // Holds every channel's buffer and the mixed buffer.
+    char *arena = nullptr;
+    qint64 chunk_samples = 0;
     float *mixed_buffer = nullptr;
-    float *downsampled_buffer = nullptr;
     soxr_t soxr = nullptr;
+    StepSynth step_synth;
+    // Where the channels are, in APU samples.
+    qint64 clock = 0;
+    // The APU sample the next output sample starts at, when rendering steps.
+    double frame_start = 0;
+    // The mixer's output at 'clock'.
+    float level = 0;
 };
 
 #endif // GENERATOR_H
@@ -1,6 +1,8 @@
 #include <QApplication>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
+#include <QScreen>
+#include <QtQml>
 #include <QSurfaceFormat>
 #include <QDebug>
 
@@ -8,6 +10,7 @@
 #include "nsfaudiofile.h"
 #include "player.h"
 #include "channelmodel.h"
+#include "toneroll.h"
 
 using namespace std;
 
@@ -39,13 +42,16 @@ int main(int argc, char *argv[])
     AudioFile audioFile;
     NsfAudioFile nsf { audio_format.sampleRate() };
     Player player { audio_format };
-    QObject::connect(&nsf, SIGNAL(channelRunsChanged(QList<QList<Run>>)),
-                     &player, SLOT(setChannels(QList<QList<Run>>)));
+    QObject::connect(&nsf, SIGNAL(channelRunsChanged(QVector<RunBuffer>)),
+                     &player, SLOT(setChannels(QVector<RunBuffer>)));
     QObject::connect(&nsf, SIGNAL(emuChanged(Music_Emu*, qreal)),
                      &player, SLOT(setEmu(Music_Emu*, qreal)));
     qRegisterMetaType<ChannelModel*>("ChannelModel*");
+    qmlRegisterType<ToneRoll>("Nestoration", 1, 0, "ToneRoll");
     engine.rootContext()->setContextProperty("audiofile", &nsf);
     engine.rootContext()->setContextProperty("player", &player);
+    player.playback_clock()->set_refresh_rate(app.primaryScreen()->refreshRate());
+    engine.rootContext()->setContextProperty("playback_clock", player.playback_clock());
     const QUrl url(QStringLiteral("qrc:/main.qml"));
     QObject::connect(&engine, &QQmlApplicationEngine::objectCreated,
                      &app, [url](QObject *obj, const QUrl &objUrl) {
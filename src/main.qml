@@ -37,6 +37,24 @@ ApplicationWindow {
         }
         viewer_to_toggle.state = new_state;
     }
+    function show_tone(tone) {
+        input_nes_timer.text = tone.nes_timer
+        input_name.text = tone.name
+        input_semitone_id.text = Math.round(tone.semitone_id * 1000) / 1000
+        input_start.text = tone.start
+        input_length.text = tone.length
+        input_volume.text = tone.volume
+        input_nes_timer_end.text = tone.nes_timer_end
+        input_shape.text = [
+                "Flat",
+                "Square 1/8",
+                "Square 1/4",
+                "Square 1/2",
+                "Square 3/4",
+                "Triangle",
+                "Irregular",
+                "Fixed"][tone.shape]
+    }
     property var open_tracks: []
     property var open_track_lengths: []
 
@@ -114,6 +132,35 @@ ApplicationWindow {
                         }
                     }
 
+                    Button {
+                        visible: track_button.visible
+                        enabled: audiofile.analysedTrackCount < open_tracks.length
+                        anchors.verticalCenter: parent.verticalCenter
+                        text: audiofile.analysedTrackCount < open_tracks.length
+                              ? qsTr("Analyse All (%1/%2)").arg(audiofile.analysedTrackCount).arg(open_tracks.length)
+                              : qsTr("All Tracks Analysed")
+                        onClicked: audiofile.analyze_all_tracks()
+                    }
+
+                    Button {
+                        visible: track_button.visible
+                        enabled: audiofile.exportProgress >= 1
+                        anchors.verticalCenter: parent.verticalCenter
+                        text: audiofile.exportProgress < 1
+                              ? qsTr("Exporting Stems (%1%)").arg(Math.round(audiofile.exportProgress * 100))
+                              : qsTr("Export Stems...")
+                        onClicked: {
+                            player.pause();
+                            audiofile.export_stems_clicked();
+                        }
+                    }
+
+                    ProgressBar {
+                        anchors.verticalCenter: parent.verticalCenter
+                        visible: audiofile.analysisProgress < 1
+                        value: audiofile.analysisProgress
+                    }
+
                     Row {
                         id: controls
                         anchors.verticalCenter: parent.verticalCenter
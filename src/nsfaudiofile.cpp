@@ -1,12 +1,11 @@
 #include "nsfaudiofile.h"
-#include "miniapu.h"
 #include "channelmodel.h"
-#include "gme/Nsf_Emu.h"
 
 #include <QDebug>
 #include <QSettings>
 #include <QFileDialog>
 #include <QDir>
+#include <QFile>
 #include <QInputDialog>
 
 const int INVALID_TRACK = -1;
@@ -15,9 +14,25 @@ NsfAudioFile::NsfAudioFile(int sample_rate, QObject *parent)
     : AudioFile(parent), blipbuf_sample_rate(sample_rate)
 {
     file_types = "NSF/NSFe (*.nsf *.NSF *.nsfe *.NSFE)";
+    QObject::connect(&this->analysis, SIGNAL(tonesFound(int, QVector<ToneObject>)),
+                     this, SLOT(add_tones(int, QVector<ToneObject>)));
+    QObject::connect(&this->analysis, SIGNAL(progressChanged(qreal)),
+                     this, SLOT(set_analysis_progress(qreal)));
+    QObject::connect(&this->analysis, SIGNAL(finished(TrackAnalysis)),
+                     this, SLOT(finish_analysis(TrackAnalysis)));
+    QObject::connect(&this->analysis, SIGNAL(failed(QString)),
+                     this, SLOT(fail_analysis(QString)));
+    QObject::connect(&this->analysis, SIGNAL(trackAnalysed(TrackAnalysis)),
+                     this, SLOT(cache_analysis(TrackAnalysis)));
+    QObject::connect(&this->stem_export, SIGNAL(progressChanged(qreal)),
+                     this, SLOT(set_export_progress(qreal)));
+    QObject::connect(&this->stem_export, SIGNAL(failed(QString)),
+                     this, SLOT(fail_export(QString)));
 }
 
 NsfAudioFile::~NsfAudioFile() {
+    this->analysis.cancel_all();
+    this->clear_cache();
     if (this->emu) {
         gme_delete(this->emu);
     }
@@ -35,15 +50,31 @@ void NsfAudioFile::openClicked() {
 }
 
 void NsfAudioFile::open(QString file_name) {
+    this->analysis.cancel_all();
     if (this->is_open) {
         this->close();
-        this->file_track = INVALID_TRACK;
     }
-    gme_err_t open_err = gme_open_file(qPrintable(file_name), &this->emu, this->blipbuf_sample_rate);
+    // Otherwise a track of the new file with the same number would be diffed against the old file's rows.
+    this->file_track = INVALID_TRACK;
+    emit this->emuChanged(nullptr, 0);
+    this->clear_cache();
+    gme_delete(this->emu);
+    this->emu = nullptr;
+    this->file_data.clear();
+    QFile file(file_name);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << file.errorString();
+        return;
+    }
+    // Every analysis job opens its own emulator from this copy, so the file is only read once.
+    QByteArray file_data = file.readAll();
+    gme_err_t open_err = gme_open_data(file_data.constData(), file_data.size(), &this->emu, this->blipbuf_sample_rate);
     if (open_err) {
         qDebug() << open_err;
         return;
     }
+    this->file_data = file_data;
+    this->file_base_name = QFileInfo(file_name).completeBaseName();
     QString file_name_only = QFileInfo(file_name).fileName();
     emit this->fileOpened(file_name_only);
     this->list_tracks();
@@ -62,160 +93,178 @@ void NsfAudioFile::list_tracks() {
         tracks.append(option);
         track_lengths.append(track_info->play_length);
     }
+    this->track_lengths = track_lengths;
     emit this->tracksListed(tracks, track_lengths);
 }
 
 void NsfAudioFile::select_track(qint16 track_num, qreal length_sec) {
-    if (track_num != INVALID_TRACK && track_num < 256) {
-        qDebug() << "Track" << track_num << "selected";
-        gme_enable_accuracy(this->emu, 1);
-        Nes_Apu *apu = static_cast<Nsf_Emu*>(this->emu)->apu_();
-        apu->apu_log_enabled = true;
-        gme_err_t start_err = gme_start_track(this->emu, track_num);
-        if (!start_err) {
-            this->is_open = true;
-            this->file_track = track_num;
+    if (track_num == INVALID_TRACK || track_num >= 256 || this->file_data.isEmpty()) {
+        return;
+    }
+    qDebug() << "Track" << track_num << "selected";
+    this->analysis.cancel();
+    bool same_track = track_num == this->file_track;
+    this->file_track = track_num;
+    auto cached = this->track_cache.constFind(track_num);
+    if (cached != this->track_cache.constEnd() && cached->length_sec == length_sec) {
+        this->show_track(*cached);
+        return;
+    }
+    // Playback stops until the new track has been analysed.
+    emit this->emuChanged(nullptr, 0);
+    if (same_track) {
+        // Re-analysis overwrites the rows as it goes, so only the tones that differ are touched.
+        this->reset_range();
+    } else {
+        this->set_tones({}, {}, {});
+    }
+    for (int &rows: this->streamed_rows) {
+        rows = 0;
+    }
+    this->set_analysis_progress(0);
+    this->analysis.start(this->file_data, this->blipbuf_sample_rate, track_num, length_sec);
+}
+
+void NsfAudioFile::analyze_all_tracks() {
+    QMap<qint16, qreal> track_lengths_sec;
+    for (int track_num = 0; track_num < this->track_lengths.size() && track_num < 256; track_num += 1) {
+        if (!this->track_cache.contains(track_num)) {
+            track_lengths_sec[track_num] = this->track_lengths[track_num] / 1000.0;
         }
     }
-    if (!this->is_open) {
-        this->close();
+    this->analysis.start_all(this->file_data, this->blipbuf_sample_rate, track_lengths_sec);
+}
+
+void NsfAudioFile::export_stems_clicked() {
+    if (this->file_data.isEmpty()) {
         return;
     }
-    this->read_gme_buffer(length_sec);
-    this->convert_apulog_to_runs(length_sec);
-    gme_seek_samples(this->emu, 0);
-    emit this->emuChanged(this->emu, length_sec);
+    QSettings settings;
+    QString starting_dir = settings.value("export_dir", QDir::homePath()).toString();
+    QString dir = QFileDialog::getExistingDirectory(nullptr, "Export each voice of every track to", starting_dir);
+    if (dir == "") {
+        return;
+    }
+    settings.setValue("export_dir", dir);
+    QMap<qint16, qreal> track_lengths_sec;
+    for (int track_num = 0; track_num < this->track_lengths.size() && track_num < 256; track_num += 1) {
+        track_lengths_sec[track_num] = this->track_lengths[track_num] / 1000.0;
+    }
+    this->stem_export.start(this->file_data, this->blipbuf_sample_rate, track_lengths_sec,
+                            QDir(dir).filePath(this->file_base_name));
+}
+
+void NsfAudioFile::set_tones(const QVector<ToneObject> &tones0, const QVector<ToneObject> &tones1,
+                             const QVector<ToneObject> &tones2) {
+    this->channel0->set_tones(tones0);
+    this->channel1->set_tones(tones1);
+    this->channel2->set_tones(tones2);
+    this->reset_range();
+}
+
+void NsfAudioFile::reset_range() {
+    this->highest_tone = -999;
+    this->lowest_tone = 999;
+}
+
+void NsfAudioFile::show_track(const TrackAnalysis &analysis) {
+    this->set_tones(analysis.tones[0], analysis.tones[1], analysis.tones[2]);
+    for (const QVector<ToneObject> &tones: analysis.tones) {
+        this->determine_range(tones);
+    }
+    emit this->lowestToneChanged(this->lowest_tone);
+    emit this->highestToneChanged(this->highest_tone);
+    this->set_analysis_progress(1);
+    this->play_track(analysis);
+}
+
+void NsfAudioFile::play_track(const TrackAnalysis &analysis) {
+    // The player may still be playing this emulator on its own thread, so
+    // take it away before rewinding. Cached emulators are left wherever
+    // playback stopped.
+    emit this->emuChanged(nullptr, 0);
+    gme_start_track(analysis.emu, analysis.track_num);
+    this->is_open = true;
+    emit this->emuChanged(analysis.emu, analysis.length_sec);
     emit this->trackOpened(this->file_track);
 }
 
-void NsfAudioFile::read_gme_buffer(qreal length_sec) {
-    const int STEREO = 2;
-    int length = this->blipbuf_sample_rate * STEREO * (length_sec + 1);
-    short *buf = new short[length];
-    Nes_Apu *apu = static_cast<Nsf_Emu*>(this->emu)->apu_();
-    gme_play(this->emu, length, buf);
-    apu->apu_log_enabled = false;
-    delete[] buf;
-}
-
-void NsfAudioFile::convert_apulog_to_runs(qreal length_sec) {
-    Nes_Apu *apu = static_cast<Nsf_Emu*>(this->emu)->apu_();
-    MiniApu miniapu;
-    QVector<ToneObject> tones[3];
-    bool has_previous[3] { false, false, false };
-    bool new_tone[3] { false, false, false };
-    sampleoff last_sample = length_sec * 1789773; /* TODO: Don't hard-code the CPU frequency. */
-    ToneObject tone[3];
-    for (int channel_i = 0; channel_i < 3; channel_i += 1) {
-        tone[channel_i].start = apu->apu_log.first().cpu_cycle;
-    }
-    /* TODO: Take sweep into account when deciding whether two tones are different. */
-    /* TODO: Take envelope into account when deciding whether two tones are different. */
-    //int prev_sweep_period = miniapu.squares[0].sweep_period();
-    short sweep_end[2] { -1, -1 };
-    std::sort(apu->apu_log.begin(), apu->apu_log.end());
-    for (const apu_log_t &entry: apu->apu_log) {
-        if (entry.event == apu_log_event::register_write) {
-            miniapu.write(entry.address, entry.data);
-        } else if (entry.event == apu_log_event::timeout) {
-            if (entry.channel < 2) {
-                miniapu.squares[static_cast<int>(entry.channel)].timed_out = true;
-            } else {
-                miniapu.triangle.timed_out = true;
-            }
-        } else if (entry.event == apu_log_event::timeout_linear) {
-            miniapu.triangle.timed_out_linear = true;
-        } else if (entry.event == apu_log_event::reloaded_linear) {
-            miniapu.triangle.timed_out_linear = false;
-        } else if (entry.event == apu_log_event::sweep && entry.cpu_cycle < last_sample) {
-            // TODO: The last_sample condition above is not the best way
-            // to make cut-off sweeping tones render accurately.
-            sweep_end[static_cast<int>(entry.channel)] = entry.data;
+void NsfAudioFile::add_tones(int channel_i, QVector<ToneObject> tones) {
+    int old_highest_tone = this->highest_tone;
+    int old_lowest_tone = this->lowest_tone;
+    ChannelModel *channels[3] { this->channel0, this->channel1, this->channel2 };
+    this->determine_range(tones);
+    channels[channel_i]->update_tones(this->streamed_rows[channel_i], tones);
+    this->streamed_rows[channel_i] += tones.size();
+    if (this->lowest_tone <= this->highest_tone) {
+        if (this->lowest_tone != old_lowest_tone) {
+            emit this->lowestToneChanged(this->lowest_tone);
         }
-        for (int channel_i = 0; channel_i < 3; channel_i += 1) {
-            if (channel_i < 2) {
-                tone[channel_i].nes_timer = miniapu.squares[channel_i].timer_whole();
-                tone[channel_i].semitone_id = period_to_semitone(16 * (tone[channel_i].nes_timer + 1));
-                tone[channel_i].volume = miniapu.squares[channel_i].out_volume();
-                tone[channel_i].shape = tone[channel_i].volume ? miniapu.squares[channel_i].duty() + 1 : CycleShape::None;
-            } else {
-                tone[channel_i].nes_timer = miniapu.triangle.timer_whole();
-                tone[channel_i].semitone_id = period_to_semitone(32 * (tone[channel_i].nes_timer + 1));
-                tone[channel_i].volume = miniapu.triangle.out_volume();
-                tone[channel_i].shape = tone[channel_i].volume ? CycleShape::Triangle : CycleShape::None;
-            }
-            if (has_previous[channel_i]) {
-                ToneObject &previous = tones[channel_i].last();
-                if (tone[channel_i].nes_timer != previous.nes_timer
-                        || tone[channel_i].shape != previous.shape
-                        || tone[channel_i].volume != previous.volume) {
-                    tone[channel_i].start = entry.cpu_cycle;
-                    previous.length = tone[channel_i].start - previous.start;
-                    if (channel_i < 2 && sweep_end[channel_i] > -1) {
-                        previous.nes_timer_end = sweep_end[channel_i];
-                        sweep_end[channel_i] = -1;
-                    }
-                    if (previous.length == 0) {
-                        // If the current tone and the previous tone started on the same CPU cycle
-                        // (such as cycle 0), then replace the previous tone with the current tone.
-                        qDebug() << "Deleting length-0 tone";
-                        tones[channel_i].removeLast();
-                    } else if (previous.length < 179 && previous.shape != CycleShape::None) {
-                        // If the previous tone was less than 1ms long, it's probably
-                        // the result of multiple register writes that only happened
-                        // at different times because the NES hardware doesn't let you
-                        // write multiple registers simultaneously. Mark these tones
-                        // as irregular.
-                        //qDebug() << "Marking irregular tone";
-                        previous.shape = CycleShape::Irregular;
-                    } else {
-                        //qDebug() << previous.start << previous.length << previous.semitone_id << previous.volume;
-                    }
-                    new_tone[channel_i] = true;
-                }
-            }
-            if (new_tone[channel_i] || !has_previous[channel_i]) {
-                tones[channel_i].append(tone[channel_i]);
-                tone[channel_i] = ToneObject {};
-                has_previous[channel_i] = true;
-                new_tone[channel_i] = false;
-            }
+        if (this->highest_tone != old_highest_tone) {
+            emit this->highestToneChanged(this->highest_tone);
         }
     }
+}
+
+void NsfAudioFile::finish_analysis(TrackAnalysis analysis) {
+    // The player was given no emulator when this analysis started, so the cached one can be replaced.
+    this->cache_track(analysis, true);
+    this->truncate_streamed_rows();
+    this->set_analysis_progress(1);
+    this->play_track(analysis);
+}
+
+void NsfAudioFile::fail_analysis(QString error) {
+    qDebug() << error;
+    this->truncate_streamed_rows();
+    this->set_analysis_progress(1);
+}
+
+// Drops whatever is left of the previous analysis of the track, past the rows this one streamed.
+void NsfAudioFile::truncate_streamed_rows() {
+    ChannelModel *channels[3] { this->channel0, this->channel1, this->channel2 };
     for (int channel_i = 0; channel_i < 3; channel_i += 1) {
-        ToneObject &final_tone = tones[channel_i].last();
-        while (final_tone.start >= last_sample) {
-            tones[channel_i].removeLast();
-            final_tone = tones[channel_i].last();
-        }
-        ToneObject filler_tone;
-        if (final_tone.length == 0 || final_tone.start + final_tone.length > last_sample) {
-            filler_tone = final_tone;
-            tones[channel_i].removeLast();
-        }
-        sampleoff filled = filler_tone.start;
-        while (filled < last_sample) {
-            // Qt crashes if a tone is 2^26 samples long or longer, so we need to make several smaller tones.
-            filler_tone.start = filled;
-            filler_tone.length = 1789773;
-            if (filler_tone.start + filler_tone.length > last_sample) {
-                filler_tone.length = last_sample - filler_tone.start;
-            }
-            filled += filler_tone.length;
-            tones[channel_i].append(filler_tone);
+        channels[channel_i]->truncate(this->streamed_rows[channel_i]);
+    }
+}
+
+void NsfAudioFile::cache_analysis(TrackAnalysis analysis) {
+    this->cache_track(analysis, false);
+}
+
+void NsfAudioFile::cache_track(const TrackAnalysis &analysis, bool replace) {
+    auto cached = this->track_cache.find(analysis.track_num);
+    if (cached != this->track_cache.end()) {
+        if (!replace) {
+            gme_delete(analysis.emu);
+            return;
         }
+        gme_delete(cached->emu);
     }
-    this->channel0->set_tones(tones[0]);
-    this->channel1->set_tones(tones[1]);
-    this->channel2->set_tones(tones[2]);
-    emit this->channel0Changed(this->channel0);
-    emit this->channel1Changed(this->channel1);
-    emit this->channel2Changed(this->channel2);
-    this->highest_tone = -999;
-    this->lowest_tone = 999;
-    this->determine_range(tones[0]);
-    this->determine_range(tones[1]);
-    this->determine_range(tones[2]);
-    emit this->lowestToneChanged(this->lowest_tone);
-    emit this->highestToneChanged(this->highest_tone);
+    this->track_cache[analysis.track_num] = analysis;
+    this->analysed_track_count = this->track_cache.size();
+    emit this->analysedTrackCountChanged(this->analysed_track_count);
+}
+
+void NsfAudioFile::clear_cache() {
+    for (const TrackAnalysis &analysis: this->track_cache) {
+        gme_delete(analysis.emu);
+    }
+    this->track_cache.clear();
+    this->analysed_track_count = 0;
+    emit this->analysedTrackCountChanged(this->analysed_track_count);
+}
+
+void NsfAudioFile::set_analysis_progress(qreal progress) {
+    this->analysis_progress = progress;
+    emit this->analysisProgressChanged(progress);
+}
+
+void NsfAudioFile::set_export_progress(qreal progress) {
+    this->export_progress = progress;
+    emit this->exportProgressChanged(progress);
+}
+
+void NsfAudioFile::fail_export(QString error) {
+    qDebug() << "Export failed:" << error;
 }
@@ -1,12 +1,19 @@
 #ifndef NSFAUDIOFILE_H
 #define NSFAUDIOFILE_H
 
+#include <QHash>
+
+#include "analysisscheduler.h"
 #include "audiofile.h"
+#include "stemexporter.h"
 #include "gme/gme.h"
 
 class NsfAudioFile : public AudioFile
 {
     Q_OBJECT
+    Q_PROPERTY(qreal analysisProgress MEMBER analysis_progress NOTIFY analysisProgressChanged)
+    Q_PROPERTY(int analysedTrackCount MEMBER analysed_track_count NOTIFY analysedTrackCountChanged)
+    Q_PROPERTY(qreal exportProgress MEMBER export_progress NOTIFY exportProgressChanged)
 
 public:
     explicit NsfAudioFile(int sample_rate, QObject *parent = 0);
@@ -14,23 +21,57 @@ public:
 
     void open(QString file_name);
     void list_tracks();
-    void read_gme_buffer(qreal length_sec);
-    void convert_apulog_to_runs(qreal length_sec);
 
 signals:
     void fileOpened(QString file_name);
     void tracksListed(QStringList tracks, QList<int> track_lengths);
     void emuChanged(Music_Emu *emu, qreal length_sec);
     void trackOpened(qint16 file_track);
+    void analysisProgressChanged(qreal analysis_progress);
+    void analysedTrackCountChanged(int analysed_track_count);
+    void exportProgressChanged(qreal export_progress);
 
 public slots:
     void openClicked();
     void select_track(qint16 track_num, qreal length_sec);
+    void analyze_all_tracks();
+    // Asks for a directory and writes every voice of every track there as its own WAV file.
+    void export_stems_clicked();
+
+private slots:
+    void add_tones(int channel_i, QVector<ToneObject> tones);
+    void finish_analysis(TrackAnalysis analysis);
+    void fail_analysis(QString error);
+    void cache_analysis(TrackAnalysis analysis);
+    void set_analysis_progress(qreal progress);
+    void set_export_progress(qreal progress);
+    void fail_export(QString error);
 
 private:
+    void set_tones(const QVector<ToneObject> &tones0, const QVector<ToneObject> &tones1,
+                   const QVector<ToneObject> &tones2);
+    void reset_range();
+    void truncate_streamed_rows();
+    void show_track(const TrackAnalysis &analysis);
+    void play_track(const TrackAnalysis &analysis);
+    void cache_track(const TrackAnalysis &analysis, bool replace);
+    void clear_cache();
+
     Music_Emu *emu { nullptr };
     const int blipbuf_sample_rate;
+    QByteArray file_data;
+    QString file_base_name;
+    QList<int> track_lengths;
     qint16 file_track = -1;
+    // Rows of each channel model that the running analysis has filled in.
+    int streamed_rows[3] { 0, 0, 0 };
+    qreal analysis_progress = 1;
+    int analysed_track_count = 0;
+    // Analysed tracks of the open file, which own their emulators.
+    QHash<qint16, TrackAnalysis> track_cache;
+    AnalysisScheduler analysis;
+    qreal export_progress = 1;
+    StemExporter stem_export;
 };
 
 #endif // NSFAUDIOFILE_H
@@ -3,33 +3,64 @@
 #include "nsfpcm.h"
 #include "gme/gme.h"
 
+#include <algorithm>
+
+// How far the producer runs ahead of the output, in seconds.
+const qreal LEAD_SEC = 0.05;
+
 NsfPcm::NsfPcm(const int output_rate)
-    : output_rate(output_rate)
+    : output_rate(output_rate), emu(nullptr), length_sec(0),
+      producer(output_rate * 2 * LEAD_SEC)
 {
-
+    std::fill(this->voice_muted, this->voice_muted + VOICES, false);
 }
 
 NsfPcm::~NsfPcm() {
+    this->producer.stop();
 }
 
 void NsfPcm::set_emu(Music_Emu *emu, qreal length_sec) {
     this->emu = emu;
     this->length_sec = length_sec;
+    this->emu_channels = emu && gme_multi_channel(emu) ? VOICES * 2 : 2;
+    this->producer.set_capacity(this->output_rate * this->emu_channels * LEAD_SEC);
 }
 
 void NsfPcm::set_mute(uint8_t channel_i, int muted) {
-    gme_mute_voice(this->emu, channel_i, muted);
+    if (channel_i < VOICES) {
+        this->voice_muted[channel_i] = muted;
+    }
+    // A stereo emulator's voices are already mixed, so it has to leave this
+    // one out. A multi-channel one plays every voice for mix_voices().
+    this->producer.mute_voice(channel_i, this->emu_channels == 2 && muted);
 }
 
 bool NsfPcm::seek_sample(qint64 sample_position) {
+    if (!this->emu) {
+        return false;
+    }
     const short STEREO = 2;
-    int stereo_sample_position = sample_position * STEREO;
-    gme_seek_samples(this->emu, stereo_sample_position);
-    qint64 byte_position = stereo_sample_position * sizeof(short);
+    this->producer.seek_samples(sample_position * this->emu_channels);
+    qint64 byte_position = sample_position * STEREO * sizeof(short);
     this->seek(byte_position);
     return true;
 }
 
+bool NsfPcm::open(OpenMode mode) {
+    if (!QIODevice::open(mode)) {
+        return false;
+    }
+    if (this->emu) {
+        this->producer.start_emu(this->emu);
+    }
+    return true;
+}
+
+void NsfPcm::close() {
+    this->producer.stop();
+    QIODevice::close();
+}
+
 bool NsfPcm::atEnd() const {
     const short STEREO = 2;
     qreal pos_sec = 1.0 * this->pos() / (sizeof(short) * STEREO) / this->output_rate;
@@ -40,11 +71,46 @@ qint64 NsfPcm::readData(char *data, qint64 bytes_requested) {
     const short STEREO = 2;
     qreal end_pos_sec = 1.0 * (this->pos() + bytes_requested) / (sizeof(short) * STEREO) / this->output_rate;
     if (end_pos_sec >= this->length_sec) {
-        bytes_requested = this->length_sec * sizeof(short) * STEREO * this->output_rate - this->pos();
+        // After a seek past the end, there's nothing left.
+        bytes_requested = std::max(qint64(this->length_sec * sizeof(short) * STEREO * this->output_rate) - this->pos(), qint64(0));
+    }
+    // Only whole stereo frames, so the channels never swap.
+    int frames_requested = bytes_requested / (sizeof(short) * STEREO);
+    short *out = reinterpret_cast<short*>(data);
+    int frames_read = 0;
+    if (this->emu_channels == STEREO) {
+        frames_read = this->producer.read(out, frames_requested * STEREO) / STEREO;
+    }
+    while (this->emu_channels != STEREO && frames_read < frames_requested) {
+        int frames = std::min(MIX_FRAMES, frames_requested - frames_read);
+        int frames_mixed = this->producer.read(this->voice_frames, frames * this->emu_channels) / this->emu_channels;
+        this->mix_voices(this->voice_frames, out + frames_read * STEREO, frames_mixed);
+        frames_read += frames_mixed;
+        if (frames_mixed < frames) {
+            break;
+        }
+    }
+    qint64 bytes_read = frames_read * STEREO * sizeof(short);
+    emit this->positionChanged(this->pos() + bytes_read);
+    return bytes_read;
+}
+
+void NsfPcm::mix_voices(const short *voice_frames, short *out, int frame_count) const {
+    float gains[VOICES];
+    for (int voice_i = 0; voice_i < VOICES; voice_i += 1) {
+        gains[voice_i] = this->voice_muted[voice_i] ? 0 : 1;
+    }
+    for (int frame_i = 0; frame_i < frame_count; frame_i += 1) {
+        const short *frame = voice_frames + frame_i * VOICES * 2;
+        float left = 0;
+        float right = 0;
+        for (int voice_i = 0; voice_i < VOICES; voice_i += 1) {
+            left += gains[voice_i] * frame[voice_i * 2];
+            right += gains[voice_i] * frame[voice_i * 2 + 1];
+        }
+        out[frame_i * 2] = short(qBound(-32768.0f, left, 32767.0f));
+        out[frame_i * 2 + 1] = short(qBound(-32768.0f, right, 32767.0f));
     }
-    int shorts_requested = bytes_requested / sizeof(short);
-    gme_play(this->emu, shorts_requested, reinterpret_cast<short*>(data));
-    return bytes_requested;
 }
 
 qint64 NsfPcm::writeData(const char *data, qint64 len)
@@ -3,8 +3,15 @@
 
 #include <QIODevice>
 
+#include "emuproducer.h"
+
 class Music_Emu;
 
+// Serves an emulator's samples to the audio output. The emulator runs
+// ahead on an EmuProducer's thread, so reading only copies samples out of
+// its ring. A multi-channel emulator renders every voice separately, and
+// the voices are mixed as they're read, so muting a voice is heard from
+// the next read rather than after the ring drains.
 class NsfPcm : public QIODevice
 {
     Q_OBJECT
@@ -18,17 +25,32 @@ public:
     void set_mute(uint8_t channel_i, int muted);
 
     bool seek_sample(qint64 sample_position);
+    // The producer runs while the device is open.
+    bool open(OpenMode mode) override;
+    void close() override;
     bool atEnd() const override;
     qint64 readData(char *data, qint64 bytes_requested) override;
     qint64 writeData(const char *data, qint64 len) override;
 
 signals:
+    // Samples up to 'byte_position' have been handed to the output.
     void positionChanged(qint64 byte_position);
 
 private:
+    static const int VOICES = 8;
+    // Frames mixed at a time.
+    static const int MIX_FRAMES = 256;
+
+    void mix_voices(const short *voice_frames, short *out, int frame_count) const;
+
     int output_rate;
     Music_Emu *emu;
     qreal length_sec;
+    EmuProducer producer;
+    // Samples per frame the emulator puts out: a stereo pair for every voice, or one for all of them.
+    int emu_channels = 2;
+    bool voice_muted[VOICES];
+    short voice_frames[MIX_FRAMES * VOICES * 2];
 };
 
 #endif // NSFPCM_H
@@ -0,0 +1,63 @@
+#include "playbackclock.h"
+
+#include <algorithm>
+#include <cmath>
+
+PlaybackClock::PlaybackClock(QObject *parent)
+    : QObject(parent)
+{
+    this->elapsed.start();
+    this->frame_timer.setTimerType(Qt::PreciseTimer);
+    this->set_refresh_rate(60);
+    QObject::connect(&this->frame_timer, SIGNAL(timeout()), this, SLOT(tick()));
+}
+
+void PlaybackClock::set_refresh_rate(qreal frames_per_sec) {
+    this->frame_timer.setInterval(std::max(1, int(std::round(1000 / frames_per_sec))));
+}
+
+qint64 PlaybackClock::predicted_cycle() const {
+    if (!this->running) {
+        return this->anchor_cycle;
+    }
+    qint64 nsec = this->elapsed.nsecsElapsed() - this->anchor_nsec;
+    return this->anchor_cycle + qint64(double(nsec) * CPU_RATE / 1e9);
+}
+
+void PlaybackClock::anchor(qint64 cycle) {
+    this->anchor_cycle = cycle;
+    this->anchor_nsec = this->elapsed.nsecsElapsed();
+}
+
+void PlaybackClock::reset(qint64 cycle) {
+    this->anchor(cycle);
+    this->limit_cycle = cycle;
+    this->displayed_cycle = cycle;
+    emit this->cycleChanged(cycle);
+}
+
+void PlaybackClock::set_limit(qint64 cycle) {
+    this->limit_cycle = cycle;
+}
+
+void PlaybackClock::set_running(bool running) {
+    if (running == this->running) {
+        return;
+    }
+    // Carry on from where the cursor is, not from the last report.
+    this->anchor(this->displayed_cycle);
+    this->running = running;
+    if (running) {
+        this->frame_timer.start();
+    } else {
+        this->frame_timer.stop();
+    }
+}
+
+void PlaybackClock::tick() {
+    qint64 cycle = std::min(this->predicted_cycle(), this->limit_cycle);
+    if (cycle > this->displayed_cycle) {
+        this->displayed_cycle = cycle;
+        emit this->cycleChanged(cycle);
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef PLAYBACKCLOCK_H
+#define PLAYBACKCLOCK_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+// Where playback is, in CPU cycles, updated once per display frame. The
+// audio output only reports its position now and then, so between reports
+// the position is carried forward by a monotonic clock. It never runs
+// backwards except on a seek, and never past the audio handed to the output.
+class PlaybackClock : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(qint64 cycle READ cycle NOTIFY cycleChanged)
+
+public:
+    static const int CPU_RATE = 1789773;
+
+    explicit PlaybackClock(QObject *parent = nullptr);
+
+    qint64 cycle() const { return this->displayed_cycle; }
+    void set_refresh_rate(qreal frames_per_sec);
+
+    // The output is playing 'cycle' right now.
+    void anchor(qint64 cycle);
+    // Playback has jumped to 'cycle', backwards or forwards.
+    void reset(qint64 cycle);
+    // The output has been given audio up to 'cycle'.
+    void set_limit(qint64 cycle);
+    void set_running(bool running);
+
+signals:
+    void cycleChanged(qint64 cycle);
+
+private slots:
+    void tick();
+
+private:
+    qint64 predicted_cycle() const;
+
+    QElapsedTimer elapsed;
+    QTimer frame_timer;
+    qint64 anchor_cycle = 0;
+    qint64 anchor_nsec = 0;
+    qint64 limit_cycle = 0;
+    qint64 displayed_cycle = 0;
+    bool running = false;
+};
+
+#endif // PLAYBACKCLOCK_H
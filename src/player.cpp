@@ -8,14 +8,19 @@ Player::Player(QAudioFormat out_format, QObject *parent) : QObject(parent) {
     this->out_format = out_format;
     this->byte_usec_ratio = out_format.sampleRate() * out_format.bytesPerFrame() / 1000000.0;
     this->audio = new QAudioOutput(out_format);
-    this->audio->setNotifyInterval(16);
-    this->audio->setBufferSize(125000 * this->byte_usec_ratio);
+    // Only to keep the playback clock from drifting. It moves the cursor between notifications.
+    this->audio->setNotifyInterval(100);
+    // Reading only copies from a ring that's already filled, so the buffer can be short.
+    this->audio->setBufferSize(50000 * this->byte_usec_ratio);
     QObject::connect(this->audio, SIGNAL(notify()), this, SLOT(handleNotify()));
     QObject::connect(this->audio, SIGNAL(stateChanged(QAudio::State)), this, SLOT(handleStateChanged(QAudio::State)));
     this->generator = new Generator { out_format.sampleRate() };
     QObject::connect(this->generator, SIGNAL(positionChanged(qint64)), this, SLOT(handlePositionChanged(qint64)));
+    this->generator->set_chunk_size(this->audio->bufferSize() / sizeof(float));
     this->generator->open(QIODevice::ReadOnly);
     this->nsf_pcm = new NsfPcm { out_format.sampleRate() };
+    QObject::connect(this->nsf_pcm, SIGNAL(positionChanged(qint64)), this, SLOT(handleBufferWritten(qint64)));
+    this->clock = new PlaybackClock { this };
 }
 
 Player::~Player() {
@@ -24,7 +29,7 @@ Player::~Player() {
     delete this->nsf_pcm;
 }
 
-void Player::setChannels(QList<QList<Run>> channel_runs) {
+void Player::setChannels(QVector<RunBuffer> channel_runs) {
     this->audio->reset();
     this->generator->setChannels(channel_runs);
 }
@@ -35,9 +40,15 @@ void Player::setEmu(Music_Emu *emu, qreal length_sec) {
     this->bytes_played = 0;
     this->seek_offset = 0;
     emit this->playerPositionChanged(this->position);
+    this->clock->reset(0);
     this->nsf_pcm->close();
     this->nsf_pcm->set_emu(emu, length_sec);
-    this->nsf_pcm->open(QIODevice::ReadOnly);
+    if (emu) {
+        for (int channel_i = 0; channel_i < 5; channel_i += 1) {
+            this->nsf_pcm->set_mute(channel_i, this->mute_states[channel_i]);
+        }
+        this->nsf_pcm->open(QIODevice::ReadOnly);
+    }
 }
 
 void Player::start() {
@@ -54,6 +65,8 @@ void Player::seek(qint64 nes_sample_position) {
     qint64 byte_position = blip_sample_position * this->out_format.bytesPerFrame();
     this->seek_offset = byte_position - this->bytes_played;
     this->nsf_pcm->seek_sample(blip_sample_position);
+    this->generator->seek_sample(nes_sample_position);
+    this->clock->reset(nes_sample_position);
 }
 
 void Player::play_pause() {
@@ -90,10 +103,16 @@ void Player::handleNotify() {
     this->bytes_played = bytes_processed - bytes_buffered;
     this->position = this->bytes_played + this->seek_offset;
     emit this->playerPositionChanged(this->position);
+    this->clock->anchor(this->bytes_to_cycles(this->position));
 }
 
 void Player::handleStateChanged(QAudio::State new_state) {
     qDebug() << "QAudioOutput state changed to:" << new_state;
+    this->clock->set_running(new_state == QAudio::ActiveState);
+    if (new_state == QAudio::ActiveState && this->audio->periodSize() > 0) {
+        // The output reads about a period at a time, which is only known once it's started.
+        this->generator->set_chunk_size(this->audio->periodSize() / sizeof(float));
+    }
     if (new_state == QAudio::IdleState && this->nsf_pcm->atEnd()) {
         this->pause();
         qDebug() << "Reached the end of the track.";
@@ -106,3 +125,12 @@ void Player::handlePositionChanged(qint64 position) {
     this->position = position;
     emit this->playerPositionChanged(position);
 }
+
+void Player::handleBufferWritten(qint64 byte_position) {
+    this->clock->set_limit(this->bytes_to_cycles(byte_position));
+}
+
+qint64 Player::bytes_to_cycles(qint64 bytes) const {
+    qint64 frames = bytes / this->out_format.bytesPerFrame();
+    return frames * PlaybackClock::CPU_RATE / this->out_format.sampleRate();
+}
@@ -7,6 +7,7 @@
 
 #include "generator.h"
 #include "nsfpcm.h"
+#include "playbackclock.h"
 #include "toneobject.h"
 
 class Music_Emu;
@@ -20,13 +21,15 @@ public:
     explicit Player(QAudioFormat out_format, QObject *parent = nullptr);
     ~Player();
     void start();
+    PlaybackClock *playback_clock() const { return this->clock; }
 
 public slots:
-    void setChannels(QList<QList<Run>> channel_runs);
+    void setChannels(QVector<RunBuffer> channel_runs);
     void setEmu(Music_Emu *emu, qreal length_sec);
     void handleNotify();
     void handleStateChanged(QAudio::State new_state);
     void handlePositionChanged(qint64 byte_position);
+    void handleBufferWritten(qint64 byte_position);
     void seek(qint64 sample_position);
     void play_pause();
     void pause();
@@ -37,11 +40,14 @@ signals:
     void playerPositionChanged(qint64 byte_position);
 
 private:
+    qint64 bytes_to_cycles(qint64 bytes) const;
+
     QAudioFormat out_format;
     qreal byte_usec_ratio;
     QAudioOutput *audio;
     Generator *generator;
     NsfPcm *nsf_pcm;
+    PlaybackClock *clock;
     qint64 position = 0;
     qint64 bytes_played = 0;
     qint64 seek_offset = 0;
@@ -0,0 +1,79 @@
+#include "runbuffer.h"
+
+#include <algorithm>
+
+RunBuffer::RunBuffer()
+{
+}
+
+RunBuffer::RunBuffer(int value_bits)
+    : wide_values(value_bits > 4)
+{
+}
+
+void RunBuffer::append(const Run &run) {
+    if (this->run_count == 0) {
+        this->first_start = run.start;
+    }
+    Q_ASSERT(run.start == this->sample_end());
+    Q_ASSERT(this->wide_values || run.value < 16);
+    if (this->run_count % CHECKPOINT_INTERVAL == 0) {
+        this->checkpoints.append({ this->lengths.size(), run.start });
+    }
+    quint64 length = run.length;
+    while (length >= 0x80) {
+        this->lengths.append(char(0x80 | (length & 0x7F)));
+        length >>= 7;
+    }
+    this->lengths.append(char(length));
+    if (this->wide_values) {
+        this->values.append(char(run.value));
+    } else if (this->run_count & 1) {
+        this->values[this->values.size() - 1] = char(this->values.at(this->values.size() - 1) | (run.value << 4));
+    } else {
+        this->values.append(char(run.value & 0x0F));
+    }
+    this->run_count += 1;
+    this->total_length += run.length;
+}
+
+void RunBuffer::clear() {
+    this->lengths.clear();
+    this->values.clear();
+    this->checkpoints.clear();
+    this->run_count = 0;
+    this->first_start = 0;
+    this->total_length = 0;
+}
+
+RunBuffer::const_iterator RunBuffer::iterator_at(int run_i) const {
+    if (run_i >= this->run_count) {
+        return this->end();
+    }
+    const Checkpoint &checkpoint = this->checkpoints.at(run_i / CHECKPOINT_INTERVAL);
+    const_iterator run = const_iterator(this, run_i - run_i % CHECKPOINT_INTERVAL,
+                                        checkpoint.length_offset, checkpoint.start);
+    while (run.index() < run_i) {
+        ++run;
+    }
+    return run;
+}
+
+RunBuffer::const_iterator RunBuffer::iterator_at_sample(sampleoff sample) const {
+    if (sample >= this->sample_end()) {
+        return this->end();
+    }
+    // The run is at or after the last checkpoint starting at or before 'sample'.
+    auto after = std::upper_bound(this->checkpoints.constBegin(), this->checkpoints.constEnd(), sample,
+                                  [](sampleoff sample, const Checkpoint &checkpoint) {
+                                      return sample < checkpoint.start;
+                                  });
+    int checkpoint_i = std::max(int(after - this->checkpoints.constBegin()) - 1, 0);
+    const Checkpoint &checkpoint = this->checkpoints.at(checkpoint_i);
+    const_iterator run = const_iterator(this, checkpoint_i * CHECKPOINT_INTERVAL,
+                                        checkpoint.length_offset, checkpoint.start);
+    while (run->start + run->length <= sample) {
+        ++run;
+    }
+    return run;
+}
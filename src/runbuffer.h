@@ -0,0 +1,182 @@
+#ifndef RUNBUFFER_H
+#define RUNBUFFER_H
+
+#include <cstddef>
+#include <iterator>
+
+#include <QByteArray>
+#include <QVector>
+#include <QtGlobal>
+
+typedef uint8_t samplevalue;
+typedef long sampleoff;
+typedef long samplesize;
+
+struct Run {
+    sampleoff start;
+    samplesize length;
+    samplevalue value;
+};
+
+// A channel's runs, packed. Runs must follow each other without gaps, so
+// each start is delta-encoded as the previous run's end and isn't stored at
+// all. Lengths are stored as LEB128 varints, usually one or two bytes, and
+// values as 4-bit nibbles, two per byte (or a byte each for wider channels
+// like the DMC). Copies share their data until one of them is appended to.
+// Every CHECKPOINT_INTERVAL runs, where that run is stored and where it
+// starts is remembered, so any run, by index or by sample, can be found by
+// decoding only a few.
+class RunBuffer
+{
+public:
+    static const int CHECKPOINT_INTERVAL = 64;
+
+    // Visits the runs in either direction, decoding one run per step.
+    class const_iterator
+    {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef Run value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Run *pointer;
+        typedef Run reference;
+
+        const_iterator() = default;
+
+        Run operator*() const { return this->run; }
+        const Run *operator->() const { return &this->run; }
+        int index() const { return this->run_i; }
+
+        const_iterator &operator++();
+        const_iterator &operator--();
+        const_iterator operator++(int) { const_iterator old = *this; ++*this; return old; }
+        const_iterator operator--(int) { const_iterator old = *this; --*this; return old; }
+        bool operator==(const const_iterator &other) const { return this->run_i == other.run_i; }
+        bool operator!=(const const_iterator &other) const { return this->run_i != other.run_i; }
+
+    private:
+        friend class RunBuffer;
+        const_iterator(const RunBuffer *buffer, int run_i, int length_offset, sampleoff start);
+        void decode();
+
+        const RunBuffer *buffer = nullptr;
+        int run_i = 0;
+        int length_offset = 0; // where the current run's length starts
+        int next_offset = 0; // where the next run's length starts
+        Run run { 0, 0, 0 };
+    };
+
+    RunBuffer();
+    // Values wider than 4 bits are stored a byte each.
+    explicit RunBuffer(int value_bits);
+
+    void append(const Run &run);
+    void clear();
+
+    int size() const { return this->run_count; }
+    bool isEmpty() const { return this->run_count == 0; }
+    int value_bits() const { return this->wide_values ? 8 : 4; }
+    // The span of samples covered by all the runs.
+    sampleoff sample_start() const { return this->first_start; }
+    sampleoff sample_end() const { return this->first_start + this->total_length; }
+    samplesize sample_length() const { return this->total_length; }
+    // Bytes used by the packed runs.
+    int packed_size() const { return this->lengths.size() + this->values.size(); }
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    // Points at run run_i, or at end() if there's no such run.
+    const_iterator iterator_at(int run_i) const;
+    // Points at the run covering 'sample', or at end() if it's past the last run.
+    const_iterator iterator_at_sample(sampleoff sample) const;
+    Run first() const { return *this->begin(); }
+    Run last() const { return *--this->end(); }
+
+private:
+    struct Checkpoint {
+        int length_offset;
+        sampleoff start;
+    };
+
+    samplevalue value_at(int run_i) const;
+
+    QByteArray lengths;
+    QByteArray values;
+    QVector<Checkpoint> checkpoints;
+    int run_count = 0;
+    sampleoff first_start = 0;
+    samplesize total_length = 0;
+    bool wide_values = false;
+};
+
+inline samplevalue RunBuffer::value_at(int run_i) const {
+    const uchar *values = reinterpret_cast<const uchar*>(this->values.constData());
+    if (this->wide_values) {
+        return values[run_i];
+    }
+    return (values[run_i >> 1] >> ((run_i & 1) << 2)) & 0x0F;
+}
+
+inline RunBuffer::const_iterator::const_iterator(const RunBuffer *buffer, int run_i, int length_offset, sampleoff start)
+    : buffer(buffer), run_i(run_i), length_offset(length_offset), next_offset(length_offset)
+{
+    this->run.start = start;
+    if (run_i < buffer->run_count) {
+        this->decode();
+    }
+}
+
+inline void RunBuffer::const_iterator::decode() {
+    const uchar *lengths = reinterpret_cast<const uchar*>(this->buffer->lengths.constData());
+    samplesize length = 0;
+    int shift = 0;
+    int offset = this->length_offset;
+    uchar byte;
+    do {
+        byte = lengths[offset];
+        length |= samplesize(byte & 0x7F) << shift;
+        shift += 7;
+        offset += 1;
+    } while (byte & 0x80);
+    this->next_offset = offset;
+    this->run.length = length;
+    this->run.value = this->buffer->value_at(this->run_i);
+}
+
+inline RunBuffer::const_iterator &RunBuffer::const_iterator::operator++() {
+    this->run.start += this->run.length;
+    this->run_i += 1;
+    this->length_offset = this->next_offset;
+    if (this->run_i < this->buffer->run_count) {
+        this->decode();
+    } else {
+        this->run.length = 0;
+        this->run.value = 0;
+    }
+    return *this;
+}
+
+inline RunBuffer::const_iterator &RunBuffer::const_iterator::operator--() {
+    // Only the last byte of a varint has its high bit clear, so the previous
+    // length starts right after the last clear byte before this one.
+    const uchar *lengths = reinterpret_cast<const uchar*>(this->buffer->lengths.constData());
+    int offset = this->length_offset - 1;
+    while (offset > 0 && (lengths[offset - 1] & 0x80)) {
+        offset -= 1;
+    }
+    this->run_i -= 1;
+    this->length_offset = offset;
+    this->decode();
+    this->run.start -= this->run.length;
+    return *this;
+}
+
+inline RunBuffer::const_iterator RunBuffer::begin() const {
+    return const_iterator(this, 0, 0, this->first_start);
+}
+
+inline RunBuffer::const_iterator RunBuffer::end() const {
+    return const_iterator(this, this->run_count, this->lengths.size(), this->sample_end());
+}
+
+#endif // RUNBUFFER_H
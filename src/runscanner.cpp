@@ -0,0 +1,160 @@
+#include "runscanner.h"
+
+#include <QtAlgorithms>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RUNSCANNER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(RUNSCANNER_SSE2) && defined(__GNUC__)
+#define RUNSCANNER_AVX2 1
+#include <immintrin.h>
+#endif
+
+RunScanner::Implementation RunScanner::best_implementation() {
+#ifdef RUNSCANNER_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return Avx2;
+    }
+#endif
+#ifdef RUNSCANNER_SSE2
+    return Sse2;
+#else
+    return Scalar;
+#endif
+}
+
+const char *RunScanner::implementation_name(Implementation implementation) {
+    switch (implementation) {
+        case Avx2:
+            return "AVX2";
+        case Sse2:
+            return "SSE2";
+        case Scalar:
+        break;
+    }
+    return "scalar";
+}
+
+RunScanner::RunScanner(Implementation implementation)
+    : implementation_(implementation)
+{
+    // The DMC's 7-bit output doesn't fit in a nibble.
+    for (int channel_i = 0; channel_i < CHANNELS; channel_i += 1) {
+        this->channel_runs[channel_i] = RunBuffer(channel_i < 4 ? 4 : 8);
+    }
+}
+
+void RunScanner::start_run(int channel_i, sampleoff frame_i, samplevalue value) {
+    int raw_value = value - 128;
+    if (channel_i < 4) {
+        raw_value = raw_value >> 3;
+    }
+    // Out of range levels would index past the end of the mixer tables.
+    raw_value = qBound(0, raw_value, channel_i < 4 ? 15 : 127);
+    this->run[channel_i] = { frame_i, 0, samplevalue(raw_value) };
+    this->previous_value[channel_i] = value;
+}
+
+inline void RunScanner::changed(const samplevalue *frames, size_t byte_i) {
+    int channel_i = byte_i % CHANNELS;
+    sampleoff frame_i = this->block_start + byte_i / CHANNELS;
+    this->run[channel_i].length = frame_i - this->run[channel_i].start;
+    this->channel_runs[channel_i].append(this->run[channel_i]);
+    this->start_run(channel_i, frame_i, frames[byte_i]);
+}
+
+// Each scan_* function visits the bytes in [begin, end) that differ from
+// the byte CHANNELS positions earlier, in order. begin must be at least CHANNELS.
+
+static void scan_scalar(RunScanner &scanner, const samplevalue *frames, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i += 1) {
+        if (frames[i] != frames[i - RunScanner::CHANNELS]) {
+            scanner.changed(frames, i);
+        }
+    }
+}
+
+#ifdef RUNSCANNER_SSE2
+static void scan_sse2(RunScanner &scanner, const samplevalue *frames, size_t begin, size_t end) {
+    size_t i = begin;
+    for (; i + 16 <= end; i += 16) {
+        __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(frames + i));
+        __m128i previous = _mm_loadu_si128(reinterpret_cast<const __m128i*>(frames + i - RunScanner::CHANNELS));
+        quint32 changes = ~_mm_movemask_epi8(_mm_cmpeq_epi8(current, previous)) & 0xFFFF;
+        while (changes) {
+            scanner.changed(frames, i + qCountTrailingZeroBits(changes));
+            changes &= changes - 1;
+        }
+    }
+    scan_scalar(scanner, frames, i, end);
+}
+#endif
+
+#ifdef RUNSCANNER_AVX2
+__attribute__((target("avx2")))
+static void scan_avx2(RunScanner &scanner, const samplevalue *frames, size_t begin, size_t end) {
+    size_t i = begin;
+    for (; i + 32 <= end; i += 32) {
+        __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(frames + i));
+        __m256i previous = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(frames + i - RunScanner::CHANNELS));
+        quint32 changes = ~static_cast<quint32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(current, previous)));
+        while (changes) {
+            scanner.changed(frames, i + qCountTrailingZeroBits(changes));
+            changes &= changes - 1;
+        }
+    }
+    scan_scalar(scanner, frames, i, end);
+}
+#endif
+
+void RunScanner::scan(const samplevalue *frames, sampleoff frame_count) {
+    if (frame_count <= 0) {
+        return;
+    }
+    this->block_start = this->frame_count;
+    // The first frame of a block is compared with the last frame of the previous one.
+    for (int channel_i = 0; channel_i < CHANNELS; channel_i += 1) {
+        if (this->frame_count == 0) {
+            this->start_run(channel_i, 0, frames[channel_i]);
+        } else if (frames[channel_i] != this->previous_value[channel_i]) {
+            this->changed(frames, channel_i);
+        }
+    }
+    size_t end = size_t(frame_count) * CHANNELS;
+    switch (this->implementation_) {
+#ifdef RUNSCANNER_AVX2
+        case Avx2:
+            scan_avx2(*this, frames, CHANNELS, end);
+        break;
+#endif
+#ifdef RUNSCANNER_SSE2
+        case Sse2:
+            scan_sse2(*this, frames, CHANNELS, end);
+        break;
+#endif
+        default:
+            scan_scalar(*this, frames, CHANNELS, end);
+        break;
+    }
+    for (int channel_i = 0; channel_i < CHANNELS; channel_i += 1) {
+        this->previous_value[channel_i] = frames[end - CHANNELS + channel_i];
+    }
+    this->frame_count += frame_count;
+}
+
+QVector<RunBuffer> RunScanner::finish() {
+    if (this->frame_count > 0) {
+        for (int channel_i = 0; channel_i < CHANNELS; channel_i += 1) {
+            this->run[channel_i].length = this->frame_count - this->run[channel_i].start;
+            this->channel_runs[channel_i].append(this->run[channel_i]);
+        }
+    }
+    QVector<RunBuffer> channel_runs;
+    for (RunBuffer &runs: this->channel_runs) {
+        channel_runs.append(runs);
+        runs.clear();
+    }
+    return channel_runs;
+}
@@ -0,0 +1,50 @@
+#ifndef RUNSCANNER_H
+#define RUNSCANNER_H
+
+#include <QVector>
+
+#include "runbuffer.h"
+
+// Splits interleaved 5-channel, 8-bit audio into runs of equal values, one
+// RunBuffer per channel. Each byte is compared with the byte one frame
+// earlier, a whole vector at a time, and only the bytes that changed are
+// visited individually.
+class RunScanner
+{
+public:
+    static const int CHANNELS = 5;
+
+    enum Implementation {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+    // The fastest implementation this CPU supports.
+    static Implementation best_implementation();
+    static const char *implementation_name(Implementation implementation);
+
+    explicit RunScanner(Implementation implementation = best_implementation());
+
+    // Scans whole frames. Consecutive calls continue the same runs.
+    void scan(const samplevalue *frames, sampleoff frame_count);
+    // Ends the open runs and returns every run found so far.
+    QVector<RunBuffer> finish();
+
+    Implementation implementation() const { return this->implementation_; }
+    sampleoff frames_scanned() const { return this->frame_count; }
+
+    // Called for each byte whose value differs from the byte one frame earlier.
+    void changed(const samplevalue *frames, size_t byte_i);
+
+private:
+    void start_run(int channel_i, sampleoff frame_i, samplevalue value);
+
+    const Implementation implementation_;
+    sampleoff frame_count = 0;
+    sampleoff block_start = 0;
+    Run run[CHANNELS];
+    samplevalue previous_value[CHANNELS];
+    RunBuffer channel_runs[CHANNELS];
+};
+
+#endif // RUNSCANNER_H
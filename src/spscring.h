@@ -0,0 +1,105 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <algorithm>
+
+#include <QAtomicInteger>
+#include <QVector>
+
+// A fixed-size ring for one thread writing and another reading, without
+// locks. Each side only moves its own position, and publishes it with
+// release/acquire ordering so the other side sees the items before the
+// position that covers them. Positions count every item ever written or
+// read, and are wrapped onto the buffer with a mask.
+template <typename T>
+class SpscRing
+{
+public:
+    // The capacity is rounded up to a power of two.
+    explicit SpscRing(int capacity);
+
+    // Neither side may be using the ring. Drops every item in it.
+    void resize(int capacity);
+
+    int capacity() const { return this->buffer.size(); }
+    // Items waiting to be read, as seen from the reading side.
+    int readable() const { return int(this->write_pos.loadAcquire() - this->read_pos.loadAcquire()); }
+    // Room left for writing, as seen from the writing side.
+    int writable() const { return this->capacity() - int(this->write_pos.loadAcquire() - this->read_pos.loadAcquire()); }
+    // How many items have ever been written.
+    quint64 written() const { return this->write_pos.loadAcquire(); }
+
+    // Writing side. Writes as many of the items as fit, and returns how many that was.
+    int write(const T *items, int count);
+    // Reading side. Reads up to 'count' items, and returns how many there were.
+    int read(T *items, int count);
+    // Reading side. Drops every item written before 'position'.
+    void discard_until(quint64 position);
+
+private:
+    QVector<T> buffer;
+    quint64 mask;
+    // On separate cache lines, so the two threads don't keep taking the line from each other.
+    alignas(64) QAtomicInteger<quint64> write_pos { 0 };
+    alignas(64) QAtomicInteger<quint64> read_pos { 0 };
+};
+
+template <typename T>
+SpscRing<T>::SpscRing(int capacity)
+{
+    this->resize(capacity);
+}
+
+template <typename T>
+void SpscRing<T>::resize(int capacity) {
+    int size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    this->buffer.resize(size);
+    this->mask = size - 1;
+    // The positions keep counting, so positions handed out before stay in order.
+    this->read_pos.storeRelease(this->write_pos.loadAcquire());
+}
+
+template <typename T>
+int SpscRing<T>::write(const T *items, int count) {
+    if (count <= 0) {
+        return 0;
+    }
+    quint64 write_pos = this->write_pos.loadAcquire();
+    count = std::min(count, this->writable());
+    T *buffer = this->buffer.data();
+    // The free space may wrap around the end of the buffer.
+    int offset = int(write_pos & this->mask);
+    int first = std::min(count, this->capacity() - offset);
+    std::copy(items, items + first, buffer + offset);
+    std::copy(items + first, items + count, buffer);
+    this->write_pos.storeRelease(write_pos + count);
+    return count;
+}
+
+template <typename T>
+int SpscRing<T>::read(T *items, int count) {
+    if (count <= 0) {
+        return 0;
+    }
+    quint64 read_pos = this->read_pos.loadAcquire();
+    count = std::min(count, this->readable());
+    const T *buffer = this->buffer.constData();
+    int offset = int(read_pos & this->mask);
+    int first = std::min(count, this->capacity() - offset);
+    std::copy(buffer + offset, buffer + offset + first, items);
+    std::copy(buffer, buffer + count - first, items + first);
+    this->read_pos.storeRelease(read_pos + count);
+    return count;
+}
+
+template <typename T>
+void SpscRing<T>::discard_until(quint64 position) {
+    if (position > this->read_pos.loadAcquire()) {
+        this->read_pos.storeRelease(position);
+    }
+}
+
+#endif // SPSCRING_H
@@ -8,25 +8,28 @@ SquareChannel::SquareChannel()
 
 }
 
-QVector<Cycle> SquareChannel::runs_to_cycles(QList<Run> &runs) {
+QVector<Cycle> SquareChannel::runs_to_cycles(const RunBuffer &runs) {
     const samplesize SEVEN_EIGHTHS_OFF = 28672; // 32768 * 7/8
     QVector<Cycle> cycles;
-    const Cycle clear_cycle = { 0, CycleShape::Irregular, -999, -999, {} };
-    for (int i=0; i < runs.size(); i += 1) {
+    const Cycle clear_cycle = { 0, CycleShape::Irregular, -999, -999, 0, 0, 0 };
+    this->original_runs = runs;
+    RunBuffer::const_iterator run_i = runs.begin();
+    while (run_i != runs.end()) {
         Cycle cycle = clear_cycle;
-        cycle.start = runs[i].start;
-        if (runs[i].value > 0) {
+        cycle.start = run_i->start;
+        cycle.first_run = run_i.index();
+        if (run_i->value > 0) {
             samplesize on_length = 0;
-            while (i < runs.size() && runs[i].value > 0) {
-                on_length += runs[i].length;
-                cycle.runs.append(runs[i]);
-                i += 1;
+            while (run_i != runs.end() && run_i->value > 0) {
+                on_length += run_i->length;
+                add_run(cycle, *run_i);
+                ++run_i;
             }
-            int next_zero = i;
-            bool on_then_off = next_zero < runs.size();
+            bool on_then_off = run_i != runs.end();
             samplesize cycle_length = on_length;
             if (on_then_off) {
-                 cycle_length += runs[next_zero].length;
+                 const Run next_zero = *run_i;
+                 cycle_length += next_zero.length;
                  bool is_normal_size = (144 <= cycle_length && cycle_length <= 32768 && (cycle_length & 15) == 0);
                  if (is_normal_size) {
                      if (on_length * 8 == cycle_length) {
@@ -39,23 +42,24 @@ QVector<Cycle> SquareChannel::runs_to_cycles(QList<Run> &runs) {
                          cycle.shape = CycleShape::SquareThreeQuarters;
                      }
                  }
-                 bool rest_follows = runs[next_zero].length > SEVEN_EIGHTHS_OFF;
-                 if (rest_follows) {
-                     i -= 1;
-                 } else {
+                 bool rest_follows = next_zero.length > SEVEN_EIGHTHS_OFF;
+                 if (!rest_follows) {
+                     // Otherwise the rest starts the next cycle.
                      cycle.semitone_id = period_to_semitone(cycle_length);
                      cycle.nes_timer = period_to_nes_timer(cycle_length);
-                     cycle.runs.append(runs[next_zero]);
+                     add_run(cycle, next_zero);
+                     ++run_i;
                  }
             }
         } else {
-            cycle.runs.append(runs[i]);
-            if (runs[i].length > SEVEN_EIGHTHS_OFF) {
+            add_run(cycle, *run_i);
+            if (run_i->length > SEVEN_EIGHTHS_OFF) {
                 cycle.shape = CycleShape::None;
             }
+            ++run_i;
         }
         cycles.append(cycle);
-        //qDebug() << cycle.start << cycle.shape << cycle.semitone_id << cycle.runs.count() << sum_run_lengths(cycle);
+        //qDebug() << cycle.start << cycle.shape << cycle.semitone_id << cycle.run_count << sum_run_lengths(cycle);
     }
     qDebug() << "Cycle count: " << cycles.size();
     return cycles;
@@ -103,19 +107,28 @@ bool tone_is_square(const ToneObject &tone) {
     );
 }
 
+// Each fix_* pass copies the tones into a new vector, replacing some of them
+// on the way, so a split never has to shift the tones after it. Like the
+// in-place passes these replaced, a tone is compared with the tone written
+// just before it, which may itself be a replacement.
+
 void SquareChannel::fix_transitional_tones(QVector<ToneObject> &tones) {
     double a, b, c;
     double midpoint;
     samplesize left_size;
-    ToneObject left, right;
-    for (int i = 1; (i+1) < tones.size(); ) {
-        if (!tone_is_square(tones[i-1]) || tone_is_square(tones[i]) || !tone_is_square(tones[i+1])) {
+    QVector<ToneObject> fixed;
+    if (tones.isEmpty()) return;
+    fixed.reserve(tones.size() + tones.size() / 2);
+    fixed.append(tones[0]);
+    for (int i = 1; i < tones.size(); i += 1) {
+        const ToneObject &previous = fixed.last();
+        if ((i+1) >= tones.size() || !tone_is_square(previous) || tone_is_square(tones[i]) || !tone_is_square(tones[i+1])) {
             // Skip tones with standard duty cycles
             // and skip tones with nonstandard neighbors.
-             i += 1;
+            fixed.append(tones[i]);
             continue;
         }
-        a = tones[i-1].semitone_id;
+        a = previous.semitone_id;
         b = tones[i].semitone_id;
         c = tones[i+1].semitone_id;
         if (a < b && b < c) {
@@ -123,12 +136,13 @@ void SquareChannel::fix_transitional_tones(QVector<ToneObject> &tones) {
         } else if (a > b && b > c) {
             midpoint = (b - c) / (a - c);
         } else {
-            i += 1;
+            fixed.append(tones[i]);
             continue;
         }
-        left_size = sum_run_lengths(tones[i-1].cycles.last()) * midpoint;
+        left_size = sum_run_lengths(previous.cycles.last()) * midpoint;
         //qDebug() << "Dividing tone" << i << "into" << left_size << "and" << tones[i].length - left_size;
-        left.semitone_id = tones[i-1].semitone_id;
+        ToneObject left, right;
+        left.semitone_id = previous.semitone_id;
         left.shape = CycleShape::Fixed;
         left.length = left_size;
         // TODO: Add cycles to left tone
@@ -136,66 +150,67 @@ void SquareChannel::fix_transitional_tones(QVector<ToneObject> &tones) {
         right.shape = CycleShape::Fixed;
         right.length = tones[i].length - left_size;
         // TODO: Add cycles to right tone
-        tones.removeAt(i);
-        tones.insert(i, left);
-        i += 1;
-        tones.insert(i, right);
-        i += 1;
+        fixed.append(left);
+        fixed.append(right);
     }
+    tones.swap(fixed);
 }
 
 void SquareChannel::fix_trailing_tones(QVector<ToneObject> &tones) {
-    ToneObject left, right;
-    for (int i = 1; i < tones.size(); ) {
-        if (!tone_is_square(tones[i-1]) || tone_is_square(tones[i]) || tones[i].shape == CycleShape::Fixed) {
+    QVector<ToneObject> fixed;
+    if (tones.isEmpty()) return;
+    fixed.reserve(tones.size() + tones.size() / 2);
+    fixed.append(tones[0]);
+    for (int i = 1; i < tones.size(); i += 1) {
+        if (!tone_is_square(fixed.last()) || tone_is_square(tones[i]) || tones[i].shape == CycleShape::Fixed) {
             // Skip tones with standard duty cycles
             // and skip tones with nonstandard neighbors.
-            i += 1;
+            fixed.append(tones[i]);
             continue;
         }
-        samplesize left_size = tones[i-1].match_after(tones[i]);
-        left.semitone_id = tones[i-1].semitone_id;
-        left.shape = tones[i-1].shape;
+        ToneObject &previous = fixed.last();
+        samplesize left_size = previous.match_after(tones[i], this->original_runs);
+        ToneObject left, right;
+        left.semitone_id = previous.semitone_id;
+        left.shape = previous.shape;
         left.length = left_size;
         right.semitone_id = -999;
         right.shape = CycleShape::None;
         right.length = tones[i].length - left_size;
-        tones.removeAt(i);
         if (left.length) {
-            tones.insert(i, left);
-            i += 1;
+            fixed.append(left);
         }
         if (right.length) {
-            tones.insert(i, right);
-            i += 1;
+            fixed.append(right);
         }
     }
+    tones.swap(fixed);
 }
 
 void SquareChannel::fix_leading_tones(QVector<ToneObject> &tones) {
-    ToneObject left, right;
-    for (int i = 0; (i+1) < tones.size(); ) {
-        if (tones[i].shape != CycleShape::Irregular || !tone_is_square(tones[i+1])) {
+    QVector<ToneObject> fixed;
+    fixed.reserve(tones.size() + tones.size() / 2);
+    for (int i = 0; i < tones.size(); i += 1) {
+        if ((i+1) >= tones.size() || tones[i].shape != CycleShape::Irregular || !tone_is_square(tones[i+1])) {
             // Skip tones with standard duty cycles
             // and skip tones with nonstandard neighbors.
-            i += 1;
+            fixed.append(tones[i]);
             continue;
         }
-        samplesize right_size = tones[i+1].match_before(tones[i]);
+        samplesize right_size = tones[i+1].match_before(tones[i], this->original_runs);
+        ToneObject left, right;
         left.semitone_id = tones[i+1].semitone_id;
         left.shape = CycleShape::Irregular;
         left.length = tones[i].length - right_size;
         right.semitone_id = tones[i+1].semitone_id;
         right.shape = CycleShape::Fixed;
         right.length = right_size;
-        tones.removeAt(i);
         if (left.length) {
-            tones.insert(i, left);
-            i += 1;
+            fixed.append(left);
         }
         if (right.length) {
-            tones.insert(i, right);
-            i += 1;
+            fixed.append(right);
         }
     }
+    tones.swap(fixed);
 }
@@ -3,7 +3,8 @@
 
 #include <QList>
 
-struct Run;
+#include "runbuffer.h"
+
 struct Cycle;
 class ToneObject;
 
@@ -12,14 +13,15 @@ class SquareChannel
 public:
     SquareChannel();
 
-    QVector<Cycle> runs_to_cycles(QList<Run> &runs);
+    QVector<Cycle> runs_to_cycles(const RunBuffer &runs);
     QVector<ToneObject> find_tones(QVector<Cycle> &cycles);
     void fix_transitional_tones(QVector<ToneObject> &tones);
     void fix_trailing_tones(QVector<ToneObject> &tones);
     void fix_leading_tones(QVector<ToneObject> &tones);
 
 private:
-    QList<Run> original_runs;
+    // The runs that the cycles refer to.
+    RunBuffer original_runs;
     QList<ToneObject> tones;
 };
 
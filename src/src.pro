@@ -21,17 +21,31 @@ DEFINES += QT_DEPRECATED_WARNINGS
 INCLUDEPATH += $$PWD/../libgme
 
 SOURCES += \
+        analysisjob.cpp \
+        analysisscheduler.cpp \
+        archiveblockreader.cpp \
         audiofile.cpp \
         channelmodel.cpp \
+        emuproducer.cpp \
         generator.cpp \
         main.cpp \
         miniapu.cpp \
         nsfaudiofile.cpp \
         nsfpcm.cpp \
+        playbackclock.cpp \
         player.cpp \
+        runbuffer.cpp \
+        runscanner.cpp \
         squarechannel.cpp \
+        stemexporter.cpp \
+        stemexportjob.cpp \
+        stepsynth.cpp \
+        toneextractor.cpp \
         toneobject.cpp \
-        trianglechannel.cpp
+        tonepyramid.cpp \
+        toneroll.cpp \
+        trianglechannel.cpp \
+        wavanalysis.cpp
 
 RESOURCES += qml.qrc
 
@@ -47,16 +61,31 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
 
 HEADERS += \
+    analysisjob.h \
+    analysisscheduler.h \
+    archiveblockreader.h \
     audiofile.h \
     channelmodel.h \
+    emuproducer.h \
     generator.h \
     miniapu.h \
     nsfaudiofile.h \
     nsfpcm.h \
+    playbackclock.h \
     player.h \
+    runbuffer.h \
+    runscanner.h \
+    spscring.h \
     squarechannel.h \
+    stemexporter.h \
+    stemexportjob.h \
+    stepsynth.h \
+    toneextractor.h \
     toneobject.h \
-    trianglechannel.h
+    tonepyramid.h \
+    toneroll.h \
+    trianglechannel.h \
+    wavanalysis.h
 
 unix: LIBS += -larchive
 macx: LIBS += -larchive
@@ -0,0 +1,61 @@
+#include "stemexporter.h"
+#include "stemexportjob.h"
+
+#include <QDebug>
+
+StemExporter::StemExporter(QObject *parent) : QObject(parent) {
+}
+
+StemExporter::~StemExporter() {
+    this->cancel();
+    this->pool.waitForDone();
+}
+
+void StemExporter::start(QByteArray file_data, int sample_rate, QMap<qint16, qreal> track_lengths_sec, QString path_prefix) {
+    this->cancel();
+    this->job_id = this->next_job_id++;
+    this->cancelled = QSharedPointer<QAtomicInt>::create(0);
+    this->track_count = track_lengths_sec.size();
+    this->track_remain = this->track_count;
+    emit this->progressChanged(this->track_remain ? 0 : 1);
+    for (auto track = track_lengths_sec.constBegin(); track != track_lengths_sec.constEnd(); ++track) {
+        QString track_prefix = path_prefix + " - " + QString::number(track.key() + 1).rightJustified(2, '0');
+        StemExportJob *job = new StemExportJob { this->job_id, this->cancelled, file_data, sample_rate,
+                                                 track.key(), track.value(), track_prefix };
+        QObject::connect(job, SIGNAL(finished(quint64, qint16)),
+                         this, SLOT(handleFinished(quint64, qint16)));
+        QObject::connect(job, SIGNAL(failed(quint64, QString)),
+                         this, SLOT(handleFailed(quint64, QString)));
+        this->pool.start(job);
+    }
+}
+
+void StemExporter::cancel() {
+    if (this->track_remain) {
+        this->cancelled->storeRelease(1);
+        this->track_remain = 0;
+        emit this->progressChanged(1);
+    }
+}
+
+// As with analysis, signals from cancelled jobs may still be queued, so
+// results only count if they belong to the running export.
+
+void StemExporter::handleFinished(quint64 job_id, qint16 track_num) {
+    if (this->track_remain && job_id == this->job_id) {
+        qDebug() << "Track" << track_num << "exported";
+        this->track_done();
+    }
+}
+
+void StemExporter::handleFailed(quint64 job_id, QString error) {
+    if (this->track_remain && job_id == this->job_id) {
+        emit this->failed(error);
+        this->track_done();
+    }
+}
+
+void StemExporter::track_done() {
+    this->track_remain -= 1;
+    emit this->progressChanged(1.0 - 1.0 * this->track_remain / this->track_count);
+}
@@ -0,0 +1,45 @@
+#ifndef STEMEXPORTER_H
+#define STEMEXPORTER_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QMap>
+#include <QObject>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+// Runs a StemExportJob for every track of a file on a thread pool, so tracks
+// are exported in parallel. Starting another export cancels the running one.
+class StemExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StemExporter(QObject *parent = nullptr);
+    ~StemExporter();
+
+    // Each track's files are named 'path_prefix', a dash, its number and its voice.
+    void start(QByteArray file_data, int sample_rate, QMap<qint16, qreal> track_lengths_sec, QString path_prefix);
+    void cancel();
+
+signals:
+    // The share of the tracks that are done, failed or not.
+    void progressChanged(qreal progress);
+    void failed(QString error);
+
+private slots:
+    void handleFinished(quint64 job_id, qint16 track_num);
+    void handleFailed(quint64 job_id, QString error);
+
+private:
+    void track_done();
+
+    QThreadPool pool;
+    quint64 next_job_id = 1;
+    QSharedPointer<QAtomicInt> cancelled;
+    quint64 job_id = 0;
+    int track_count = 0;
+    int track_remain = 0;
+};
+
+#endif // STEMEXPORTER_H
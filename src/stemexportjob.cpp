@@ -0,0 +1,139 @@
+#include "stemexportjob.h"
+#include "wavanalysis.h"
+#include "gme/gme.h"
+
+#include <QFile>
+#include <QVector>
+
+#include <algorithm>
+#include <cstring>
+
+// Frames rendered and written at a time. A frame holds a stereo pair for every voice.
+const int CHUNK_FRAMES = 4096;
+// Voices the emulator renders separately. Any more are rendered together with the last one.
+const int MAX_STEMS = 8;
+const int STEREO = 2;
+
+StemExportJob::StemExportJob(quint64 job_id, QSharedPointer<QAtomicInt> cancelled, QByteArray file_data,
+                             int sample_rate, qint16 track_num, qreal length_sec, QString path_prefix)
+    : job_id(job_id), cancelled(cancelled), file_data(file_data), sample_rate(sample_rate),
+      track_num(track_num), length_sec(length_sec), path_prefix(path_prefix)
+{
+    // The job deletes itself with deleteLater() once its signals have been sent.
+    this->setAutoDelete(false);
+}
+
+static WAVheader mono_wav_header(int sample_rate, quint32 data_size) {
+    WAVheader header;
+    memcpy(header.RIFF_literal, "RIFF", 4);
+    header.chunk_size = sizeof(WAVheader) - 8 + data_size;
+    memcpy(header.WAVE_literal, "WAVE", 4);
+    memcpy(header.fmt__literal, "fmt ", 4);
+    header.subchunk1_size = 16;
+    header.audio_format = 1;
+    header.num_channels = 1;
+    header.sample_rate = sample_rate;
+    header.byte_rate = sample_rate * sizeof(short);
+    header.block_align = sizeof(short);
+    header.bits_per_sample = 16;
+    memcpy(header.data_literal, "data", 4);
+    header.subchunk2_size = data_size;
+    return header;
+}
+
+void StemExportJob::run() {
+    if (this->cancelled->loadAcquire()) {
+        this->deleteLater();
+        return;
+    }
+    Music_Emu *emu { nullptr };
+    gme_err_t err = gme_open_data_multi_channel(this->file_data.constData(), this->file_data.size(), &emu, this->sample_rate);
+    if (!err && !gme_multi_channel(emu)) {
+        err = "This file's voices can't be rendered separately";
+    }
+    if (!err) {
+        gme_enable_accuracy(emu, 1);
+        err = gme_start_track(emu, this->track_num);
+    }
+    QString error = err ? QString(err) : this->export_voices(emu);
+    gme_delete(emu);
+    if (this->cancelled->loadAcquire()) {
+        this->deleteLater();
+        return;
+    }
+    if (error.isEmpty()) {
+        emit this->finished(this->job_id, this->track_num);
+    } else {
+        emit this->failed(this->job_id, error);
+    }
+    this->deleteLater();
+}
+
+// Returns an error message, or an empty string once every file is written.
+// Files are removed again if anything goes wrong.
+QString StemExportJob::export_voices(Music_Emu *emu) {
+    int voice_count = gme_voice_count(emu);
+    int stem_count = std::min(voice_count, MAX_STEMS);
+    QString error;
+    QVector<QFile*> files;
+    for (int stem_i = 0; stem_i < stem_count; stem_i += 1) {
+        QString voice_name = gme_voice_name(emu, stem_i);
+        if (stem_i == MAX_STEMS - 1 && voice_count > MAX_STEMS) {
+            voice_name += QString(" to ") + gme_voice_name(emu, voice_count - 1);
+        }
+        QFile *file = new QFile(this->path_prefix + " - " + voice_name + ".wav");
+        files.append(file);
+        // The header is written again once the length is known.
+        WAVheader header = mono_wav_header(this->sample_rate, 0);
+        if (!file->open(QIODevice::WriteOnly) || file->write(reinterpret_cast<const char*>(&header), sizeof(header)) != sizeof(header)) {
+            error = file->fileName() + ": " + file->errorString();
+            break;
+        }
+    }
+
+    const int channels = MAX_STEMS * STEREO;
+    QVector<short> chunk(CHUNK_FRAMES * channels);
+    QVector<short> stem(CHUNK_FRAMES);
+    const qint64 total_frames = this->length_sec * this->sample_rate;
+    qint64 frames_left = total_frames;
+    while (error.isEmpty() && frames_left > 0) {
+        if (this->cancelled->loadAcquire()) {
+            error = "Cancelled";
+            break;
+        }
+        int frames = std::min<qint64>(frames_left, CHUNK_FRAMES);
+        gme_err_t err = gme_play(emu, frames * channels, chunk.data());
+        if (err) {
+            error = err;
+            break;
+        }
+        qint64 stem_bytes = frames * sizeof(short);
+        for (int stem_i = 0; stem_i < stem_count && error.isEmpty(); stem_i += 1) {
+            // Each voice is mono, so only the left of its pair is kept.
+            const short *in = chunk.constData() + stem_i * STEREO;
+            for (int frame_i = 0; frame_i < frames; frame_i += 1) {
+                stem[frame_i] = in[frame_i * channels];
+            }
+            QFile *file = files[stem_i];
+            if (file->write(reinterpret_cast<const char*>(stem.constData()), stem_bytes) != stem_bytes) {
+                error = file->fileName() + ": " + file->errorString();
+            }
+        }
+        frames_left -= frames;
+    }
+
+    WAVheader header = mono_wav_header(this->sample_rate, total_frames * sizeof(short));
+    for (QFile *file: files) {
+        if (error.isEmpty() && (!file->seek(0) || file->write(reinterpret_cast<const char*>(&header), sizeof(header)) != sizeof(header))) {
+            error = file->fileName() + ": " + file->errorString();
+        }
+        file->close();
+    }
+    if (!error.isEmpty()) {
+        for (QFile *file: files) {
+            file->remove();
+        }
+    }
+    qDeleteAll(files);
+    return error;
+}
@@ -0,0 +1,45 @@
+#ifndef STEMEXPORTJOB_H
+#define STEMEXPORTJOB_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QObject>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QString>
+
+class Music_Emu;
+
+// Renders every voice of one NSF track to its own mono WAV file on a thread
+// pool, as fast as the emulator runs. All the voices come out of one pass of
+// a multi-channel emulator, and each chunk is written out as soon as it's
+// rendered, so memory use doesn't grow with the track's length. Setting the
+// shared cancel flag stops the job at the next chunk and removes its files.
+class StemExportJob : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    // Files are named 'path_prefix', a dash and the voice's name.
+    StemExportJob(quint64 job_id, QSharedPointer<QAtomicInt> cancelled, QByteArray file_data,
+                  int sample_rate, qint16 track_num, qreal length_sec, QString path_prefix);
+
+    void run() override;
+
+signals:
+    void finished(quint64 job_id, qint16 track_num);
+    void failed(quint64 job_id, QString error);
+
+private:
+    QString export_voices(Music_Emu *emu);
+
+    const quint64 job_id;
+    QSharedPointer<QAtomicInt> cancelled;
+    const QByteArray file_data;
+    const int sample_rate;
+    const qint16 track_num;
+    const qreal length_sec;
+    const QString path_prefix;
+};
+
+#endif // STEMEXPORTJOB_H
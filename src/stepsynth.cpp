@@ -0,0 +1,62 @@
+#include "stepsynth.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Impulses are cut off a little below Nyquist, so the window has room to fall off.
+const double CUTOFF = 0.9;
+
+StepSynth::StepSynth()
+{
+    for (int phase = 0; phase < PHASES; phase += 1) {
+        double offset = double(phase) / PHASES;
+        double total = 0;
+        for (int tap = 0; tap < WIDTH; tap += 1) {
+            double x = tap - WIDTH / 2 - offset;
+            double sinc = x == 0 ? 1 : std::sin(M_PI * CUTOFF * x) / (M_PI * CUTOFF * x);
+            // Blackman window, falling to zero just outside the kernel.
+            double w = (x + WIDTH / 2 + 1) / (WIDTH + 1);
+            double window = 0.42 - 0.5 * std::cos(2 * M_PI * w) + 0.08 * std::cos(4 * M_PI * w);
+            this->kernel[phase][tap] = sinc * window;
+            total += this->kernel[phase][tap];
+        }
+        // Every phase must add up to exactly one step.
+        for (int tap = 0; tap < WIDTH; tap += 1) {
+            this->kernel[phase][tap] /= total;
+        }
+    }
+}
+
+void StepSynth::reserve(int count) {
+    if (this->differences.size() < count + WIDTH) {
+        this->differences.resize(count + WIDTH);
+    }
+}
+
+void StepSynth::add_step(double time, float delta) {
+    int sample_i = int(time);
+    int phase = int((time - sample_i) * PHASES);
+    this->reserve(sample_i + 1);
+    float *differences = this->differences.data() + sample_i;
+    for (int tap = 0; tap < WIDTH; tap += 1) {
+        differences[tap] += delta * this->kernel[phase][tap];
+    }
+}
+
+void StepSynth::read_samples(float out[], int count) {
+    this->reserve(count);
+    float *differences = this->differences.data();
+    for (int sample_i = 0; sample_i < count; sample_i += 1) {
+        this->sum += differences[sample_i];
+        out[sample_i] = this->sum;
+    }
+    // Keep the tails of impulses that reach past the samples read.
+    int left = this->differences.size() - count;
+    std::copy(differences + count, differences + count + left, differences);
+    std::fill(differences + left, differences + this->differences.size(), 0.0f);
+}
+
+void StepSynth::clear() {
+    this->differences.fill(0);
+    this->sum = 0;
+}
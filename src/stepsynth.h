@@ -0,0 +1,36 @@
+#ifndef STEPSYNTH_H
+#define STEPSYNTH_H
+
+#include <QVector>
+
+// Turns a signal made of steps into band-limited samples at the output
+// rate. Each step adds a windowed-sinc impulse to a buffer of differences,
+// which is summed into samples as they're read. Output is delayed by
+// WIDTH / 2 samples, so every impulse fits after the time it's added at.
+class StepSynth
+{
+public:
+    static const int WIDTH = 16;
+    static const int PHASES = 64;
+
+    StepSynth();
+
+    // Adds a step of height 'delta' at 'time', counted in output samples
+    // from the start of the next read.
+    void add_step(double time, float delta);
+    // Writes the next 'count' samples, and moves time forward by as much.
+    void read_samples(float out[], int count);
+    // Forgets every step and starts from silence.
+    void clear();
+    // Makes room for steps up to 'count' samples ahead, so that adding
+    // them and reading them doesn't allocate.
+    void reserve(int count);
+
+private:
+    // The impulse at each fraction of a sample, PHASES to a sample.
+    float kernel[PHASES][WIDTH];
+    QVector<float> differences;
+    double sum = 0;
+};
+
+#endif // STEPSYNTH_H
@@ -0,0 +1,137 @@
+#include "toneextractor.h"
+#include "gme/Apu_Log.h"
+
+#include <QDebug>
+
+ToneExtractor::ToneExtractor(sampleoff last_sample)
+    : last_sample(last_sample)
+{
+}
+
+void ToneExtractor::feed(const Apu_Log &log) {
+    // The log is recorded in cycle order, so it can be replayed as-is.
+    for (const apu_log_t &entry: log) {
+        this->feed(entry);
+    }
+}
+
+void ToneExtractor::feed(const apu_log_t &entry) {
+    if (!this->started) {
+        for (int channel_i = 0; channel_i < 3; channel_i += 1) {
+            this->tone[channel_i].start = entry.cpu_cycle;
+        }
+        this->started = true;
+    }
+    /* TODO: Take sweep into account when deciding whether two tones are different. */
+    /* TODO: Take envelope into account when deciding whether two tones are different. */
+    if (entry.event == apu_log_event::register_write) {
+        this->miniapu.write(entry.address, entry.data);
+    } else if (entry.event == apu_log_event::timeout) {
+        if (entry.channel < 2) {
+            this->miniapu.squares[static_cast<int>(entry.channel)].timed_out = true;
+        } else {
+            this->miniapu.triangle.timed_out = true;
+        }
+    } else if (entry.event == apu_log_event::timeout_linear) {
+        this->miniapu.triangle.timed_out_linear = true;
+    } else if (entry.event == apu_log_event::reloaded_linear) {
+        this->miniapu.triangle.timed_out_linear = false;
+    } else if (entry.event == apu_log_event::sweep && entry.cpu_cycle < this->last_sample) {
+        // TODO: The last_sample condition above is not the best way
+        // to make cut-off sweeping tones render accurately.
+        this->sweep_end[static_cast<int>(entry.channel)] = entry.data;
+    }
+    for (int channel_i = 0; channel_i < 3; channel_i += 1) {
+        ToneObject &tone = this->tone[channel_i];
+        QVector<ToneObject> &tones = this->tones[channel_i];
+        if (channel_i < 2) {
+            tone.nes_timer = this->miniapu.squares[channel_i].timer_whole();
+            tone.semitone_id = period_to_semitone(16 * (tone.nes_timer + 1));
+            tone.volume = this->miniapu.squares[channel_i].out_volume();
+            tone.shape = tone.volume ? this->miniapu.squares[channel_i].duty() + 1 : CycleShape::None;
+        } else {
+            tone.nes_timer = this->miniapu.triangle.timer_whole();
+            tone.semitone_id = period_to_semitone(32 * (tone.nes_timer + 1));
+            tone.volume = this->miniapu.triangle.out_volume();
+            tone.shape = tone.volume ? CycleShape::Triangle : CycleShape::None;
+        }
+        if (this->has_previous[channel_i]) {
+            ToneObject &previous = tones.last();
+            if (tone.nes_timer != previous.nes_timer
+                    || tone.shape != previous.shape
+                    || tone.volume != previous.volume) {
+                tone.start = entry.cpu_cycle;
+                previous.length = tone.start - previous.start;
+                if (channel_i < 2 && this->sweep_end[channel_i] > -1) {
+                    previous.nes_timer_end = this->sweep_end[channel_i];
+                    this->sweep_end[channel_i] = -1;
+                }
+                if (previous.length == 0) {
+                    // If the current tone and the previous tone started on the same CPU cycle
+                    // (such as cycle 0), then replace the previous tone with the current tone.
+                    qDebug() << "Deleting length-0 tone";
+                    tones.removeLast();
+                } else if (previous.length < 179 && previous.shape != CycleShape::None) {
+                    // If the previous tone was less than 1ms long, it's probably
+                    // the result of multiple register writes that only happened
+                    // at different times because the NES hardware doesn't let you
+                    // write multiple registers simultaneously. Mark these tones
+                    // as irregular.
+                    previous.shape = CycleShape::Irregular;
+                }
+                this->new_tone[channel_i] = true;
+            }
+        }
+        if (this->new_tone[channel_i] || !this->has_previous[channel_i]) {
+            tones.append(tone);
+            tone = ToneObject {};
+            this->has_previous[channel_i] = true;
+            this->new_tone[channel_i] = false;
+        }
+    }
+}
+
+QVector<ToneObject> ToneExtractor::take_finished(int channel_i) {
+    // Every tone but the last one is final, except that a tone reaching
+    // past last_sample may still be cut short by finish().
+    QVector<ToneObject> &tones = this->tones[channel_i];
+    int finished = 0;
+    while (finished < tones.size() - 1
+            && tones[finished].start + tones[finished].length <= this->last_sample) {
+        finished += 1;
+    }
+    QVector<ToneObject> taken = tones.mid(0, finished);
+    tones.remove(0, finished);
+    return taken;
+}
+
+QVector<ToneObject> ToneExtractor::finish(int channel_i) {
+    QVector<ToneObject> &tones = this->tones[channel_i];
+    while (!tones.isEmpty() && tones.last().start >= this->last_sample) {
+        tones.removeLast();
+    }
+    ToneObject filler_tone;
+    sampleoff filled = this->last_sample;
+    if (!tones.isEmpty()) {
+        const ToneObject &final_tone = tones.last();
+        filled = final_tone.start + final_tone.length;
+        if (final_tone.length == 0 || filled > this->last_sample) {
+            filler_tone = final_tone;
+            filled = final_tone.start;
+            tones.removeLast();
+        }
+    }
+    while (filled < this->last_sample) {
+        // Qt crashes if a tone is 2^26 samples long or longer, so we need to make several smaller tones.
+        filler_tone.start = filled;
+        filler_tone.length = 1789773;
+        if (filler_tone.start + filler_tone.length > this->last_sample) {
+            filler_tone.length = this->last_sample - filler_tone.start;
+        }
+        filled += filler_tone.length;
+        tones.append(filler_tone);
+    }
+    QVector<ToneObject> taken = tones;
+    tones.clear();
+    return taken;
+}
@@ -0,0 +1,36 @@
+#ifndef TONEEXTRACTOR_H
+#define TONEEXTRACTOR_H
+
+#include <QVector>
+
+#include "miniapu.h"
+#include "toneobject.h"
+
+class Apu_Log;
+struct apu_log_t;
+
+// Turns an APU log into tones for the two square channels and the triangle.
+// The log can be fed in pieces while the track is still being emulated, and
+// tones can be taken out as soon as they're finished.
+class ToneExtractor
+{
+public:
+    explicit ToneExtractor(sampleoff last_sample = 0);
+
+    void feed(const Apu_Log &log);
+    void feed(const apu_log_t &entry);
+    QVector<ToneObject> take_finished(int channel_i);
+    QVector<ToneObject> finish(int channel_i);
+
+private:
+    MiniApu miniapu;
+    sampleoff last_sample;
+    bool started { false };
+    QVector<ToneObject> tones[3];
+    bool has_previous[3] { false, false, false };
+    bool new_tone[3] { false, false, false };
+    ToneObject tone[3];
+    short sweep_end[2] { -1, -1 };
+};
+
+#endif // TONEEXTRACTOR_H
@@ -23,25 +23,33 @@ ToneObject::ToneObject(const double &semitone_id, qint16 nes_timer, const short
     this->cycles = {};
 }
 
-double ToneObject::semitone_id_end() const {
-    samplesize period = 16 * (this->nes_timer_end + 1);
-    if (period == 0) return this->semitone_id;
+double semitone_id_end(double semitone_id, qint16 nes_timer_end) {
+    samplesize period = 16 * (nes_timer_end + 1);
+    if (period == 0) return semitone_id;
     return period_to_semitone(period);
 }
 
-QString ToneObject::name() const {
-    if (this->semitone_id < 0) {
+QString semitone_name(double semitone_id) {
+    if (semitone_id < 0) {
         return "Silence";
     }
-    int closest = round(this->semitone_id);
+    int closest = round(semitone_id);
     QString name_only = note_names[closest % 12];
     QString octave = QString::number(closest / 12 - 1);
-    int cents = 100 * (this->semitone_id - closest);
+    int cents = 100 * (semitone_id - closest);
     QString cents_plus = cents > 0 ? "+" : "";
     return name_only + octave + cents_plus + QString::number(cents) + "¢";
 }
 
-samplesize ToneObject::match_before(ToneObject &before, samplesize max_length) {
+double ToneObject::semitone_id_end() const {
+    return ::semitone_id_end(this->semitone_id, this->nes_timer_end);
+}
+
+QString ToneObject::name() const {
+    return semitone_name(this->semitone_id);
+}
+
+samplesize ToneObject::match_before(ToneObject &before, const RunBuffer &runs, samplesize max_length) {
     samplesize matched_length {0};
 
     if (max_length == 0) {
@@ -49,30 +57,36 @@ samplesize ToneObject::match_before(ToneObject &before, samplesize max_length) {
     } else {
         max_length = std::min(before.length, max_length);
     }
-    QList<Run>::reverse_iterator ref_i, cand_i;
     if (this->cycles.isEmpty() or before.cycles.isEmpty()) {
         return 0;
     }
-    ref_i = this->cycles.first().runs.rbegin();
-    cand_i = before.cycles.last().runs.rbegin();
-    while (ref_i != this->cycles.first().runs.rend() && cand_i != before.cycles.last().runs.rend()) {
-        samplesize reference = ref_i->length;
-        samplesize candidate = cand_i->length;
+    const Cycle &ref_cycle = this->cycles.constFirst();
+    const Cycle &cand_cycle = before.cycles.constLast();
+    RunBuffer::const_iterator ref_i = runs.iterator_at(ref_cycle.first_run + ref_cycle.run_count - 1);
+    RunBuffer::const_iterator cand_i = runs.iterator_at(cand_cycle.first_run + cand_cycle.run_count - 1);
+    while (true) {
+        const Run ref_run = *ref_i;
+        const Run cand_run = *cand_i;
+        samplesize reference = ref_run.length;
+        samplesize candidate = cand_run.length;
         samplesize new_matched = 0;
-        if (ref_i->value == cand_i->value) {
+        if (ref_run.value == cand_run.value) {
             new_matched = std::min(reference, candidate);
         }
         matched_length += new_matched;
         if (new_matched < reference || matched_length >= max_length) {
             break;
         }
-        ref_i += 1;
-        cand_i += 1;
+        if (ref_i.index() == ref_cycle.first_run || cand_i.index() == cand_cycle.first_run) {
+            break;
+        }
+        --ref_i;
+        --cand_i;
     }
     return std::min(matched_length, max_length);
 }
 
-samplesize ToneObject::match_after(ToneObject &after, samplesize max_length) {
+samplesize ToneObject::match_after(ToneObject &after, const RunBuffer &runs, samplesize max_length) {
     samplesize matched_length {0};
 
     if (max_length == 0) {
@@ -80,25 +94,29 @@ samplesize ToneObject::match_after(ToneObject &after, samplesize max_length) {
     } else {
         max_length = std::min(after.length, max_length);
     }
-    QList<Run>::iterator ref_i, cand_i;
     if (this->cycles.isEmpty() or after.cycles.isEmpty()) {
         return 0;
     }
-    ref_i = this->cycles.last().runs.begin();
-    cand_i = after.cycles.first().runs.begin();
-    while (ref_i != this->cycles.last().runs.end() && cand_i != after.cycles.first().runs.end()) {
-        samplesize reference = ref_i->length;
-        samplesize candidate = cand_i->length;
+    const Cycle &ref_cycle = this->cycles.constLast();
+    const Cycle &cand_cycle = after.cycles.constFirst();
+    RunBuffer::const_iterator ref_i = runs.iterator_at(ref_cycle.first_run);
+    RunBuffer::const_iterator cand_i = runs.iterator_at(cand_cycle.first_run);
+    while (ref_i.index() < ref_cycle.first_run + ref_cycle.run_count
+            && cand_i.index() < cand_cycle.first_run + cand_cycle.run_count) {
+        const Run ref_run = *ref_i;
+        const Run cand_run = *cand_i;
+        samplesize reference = ref_run.length;
+        samplesize candidate = cand_run.length;
         samplesize new_matched = 0;
-        if (ref_i->value == cand_i->value) {
+        if (ref_run.value == cand_run.value) {
             new_matched = std::min(reference, candidate);
         }
         matched_length += new_matched;
         if (new_matched < reference || matched_length >= max_length) {
             break;
         }
-        ref_i += 1;
-        cand_i += 1;
+        ++ref_i;
+        ++cand_i;
     }
     return std::min(matched_length, max_length);
 }
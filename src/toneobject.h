@@ -6,9 +6,7 @@
 #include <QStringList>
 #include <QVector>
 
-typedef uint8_t samplevalue;
-typedef long sampleoff;
-typedef long samplesize;
+#include "runbuffer.h"
 
 const double CPU_FREQENCY = 1789773.0;
 const double TWELFTH_ROOT = pow(2.0, 1.0 / 12.0);
@@ -26,32 +24,30 @@ enum CycleShape {
     Fixed
 };
 
-struct Run {
-    sampleoff start;
-    samplesize length;
-    samplevalue value;
-};
-
 struct BoolRun {
     sampleoff start;
     samplesize length;
     bool on;
 };
 
+// A cycle is made of run_count runs of its channel, starting with run first_run.
 struct Cycle {
     sampleoff start;
     CycleShape shape;
     double semitone_id;
     qint16 nes_timer;
-    QList<Run> runs;
+    int first_run;
+    int run_count;
+    samplesize length;
 };
 
-inline samplesize sum_run_lengths(Cycle &cycle) {
-    samplesize runs_total = 0;
-    for (Run &run: cycle.runs) {
-        runs_total += run.length;
-    }
-    return runs_total;
+inline void add_run(Cycle &cycle, const Run &run) {
+    cycle.run_count += 1;
+    cycle.length += run.length;
+}
+
+inline samplesize sum_run_lengths(const Cycle &cycle) {
+    return cycle.length;
 }
 
 inline double period_to_semitone(const samplesize &period) {
@@ -64,6 +60,9 @@ inline qint16 period_to_nes_timer(const samplesize &period) {
     return nes_timer;
 }
 
+double semitone_id_end(double semitone_id, qint16 nes_timer_end);
+QString semitone_name(double semitone_id);
+
 class ToneObject {
 
 public:
@@ -81,8 +80,9 @@ public:
 
     QString name() const;
     double semitone_id_end() const;
-    samplesize match_before(ToneObject &before, samplesize max_length = 0);
-    samplesize match_after(ToneObject &after, samplesize max_length = 0);
+    // Both tones' cycles must refer to runs.
+    samplesize match_before(ToneObject &before, const RunBuffer &runs, samplesize max_length = 0);
+    samplesize match_after(ToneObject &after, const RunBuffer &runs, samplesize max_length = 0);
 
 private:
 };
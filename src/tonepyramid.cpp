@@ -0,0 +1,105 @@
+#include "tonepyramid.h"
+#include "channelmodel.h"
+
+#include <algorithm>
+
+const int SHAPE_COUNT = CycleShape::Fixed + 1;
+const ToneSummary SILENT_SUMMARY { 0, 0, CycleShape::None, 0, 0 };
+
+static bool is_sounding(const ToneRow &tone) {
+    return tone.shape != CycleShape::None && tone.semitone_id > -999;
+}
+
+void TonePyramid::build(const QVector<ToneRow> &rows) {
+    this->levels.clear();
+    this->total_length = 0;
+    for (const ToneRow &tone: rows) {
+        this->total_length += tone.length;
+    }
+    if (this->total_length == 0) {
+        return;
+    }
+
+    // Level 0 is filled in one pass over the tones, splitting tones at bucket edges.
+    QVector<ToneSummary> base((this->total_length + bucket_span(0) - 1) >> BASE_SHIFT, SILENT_SUMMARY);
+    samplesize shape_lengths[SHAPE_COUNT] {};
+    ToneSummary current = SILENT_SUMMARY;
+    bool sounding = false;
+    int bucket_i = 0;
+    auto finish_bucket = [&]() {
+        if (sounding) {
+            int dominant = std::max_element(shape_lengths + 1, shape_lengths + SHAPE_COUNT) - shape_lengths;
+            current.shape = dominant;
+            current.shape_length = shape_lengths[dominant];
+        }
+        base[bucket_i] = current;
+        std::fill(shape_lengths, shape_lengths + SHAPE_COUNT, 0);
+        current = SILENT_SUMMARY;
+        sounding = false;
+    };
+    sampleoff x = 0;
+    for (const ToneRow &tone: rows) {
+        sampleoff end = x + tone.length;
+        int shape = qBound(0, int(tone.shape), SHAPE_COUNT - 1);
+        float semitone = tone.semitone_id;
+        float semitone_end = semitone_id_end(tone.semitone_id, tone.nes_timer_end);
+        while (x < end) {
+            if ((x >> BASE_SHIFT) != bucket_i) {
+                finish_bucket();
+                bucket_i = x >> BASE_SHIFT;
+            }
+            samplesize part = std::min(end, sampleoff(bucket_i + 1) << BASE_SHIFT) - x;
+            shape_lengths[shape] += part;
+            if (is_sounding(tone)) {
+                if (!sounding) {
+                    current.min_semitone = std::min(semitone, semitone_end);
+                    current.max_semitone = std::max(semitone, semitone_end);
+                    sounding = true;
+                } else {
+                    current.min_semitone = std::min({ current.min_semitone, semitone, semitone_end });
+                    current.max_semitone = std::max({ current.max_semitone, semitone, semitone_end });
+                }
+                current.peak_volume = std::max(current.peak_volume, tone.volume);
+            }
+            x += part;
+        }
+    }
+    finish_bucket();
+    this->levels.append(base);
+
+    while (this->levels.last().size() > 1) {
+        const QVector<ToneSummary> &below = this->levels.last();
+        QVector<ToneSummary> above((below.size() + 1) / 2);
+        for (int i = 0; i < above.size(); i += 1) {
+            above[i] = 2 * i + 1 < below.size() ? merge(below[2 * i], below[2 * i + 1]) : below[2 * i];
+        }
+        this->levels.append(above);
+    }
+}
+
+// The merged shape is exact when both halves agree. Otherwise it's the
+// shape of whichever half has more of its own, which is close enough to draw.
+ToneSummary TonePyramid::merge(const ToneSummary &a, const ToneSummary &b) {
+    if (a.shape == CycleShape::None) {
+        return b;
+    }
+    if (b.shape == CycleShape::None) {
+        return a;
+    }
+    ToneSummary merged = a.shape_length >= b.shape_length ? a : b;
+    if (a.shape == b.shape) {
+        merged.shape_length = a.shape_length + b.shape_length;
+    }
+    merged.min_semitone = std::min(a.min_semitone, b.min_semitone);
+    merged.max_semitone = std::max(a.max_semitone, b.max_semitone);
+    merged.peak_volume = std::max(a.peak_volume, b.peak_volume);
+    return merged;
+}
+
+int TonePyramid::level_for_span(samplesize max_span) const {
+    int level = -1;
+    while (level + 1 < this->levels.size() && bucket_span(level + 1) <= max_span) {
+        level += 1;
+    }
+    return level;
+}
@@ -0,0 +1,49 @@
+#ifndef TONEPYRAMID_H
+#define TONEPYRAMID_H
+
+#include <QVector>
+
+#include "toneobject.h"
+
+struct ToneRow;
+
+// What's in one bucket of a TonePyramid level.
+struct ToneSummary {
+    // The range of semitones sounding in the bucket, including sweeps.
+    float min_semitone;
+    float max_semitone;
+    // The shape sounding for the most samples, or None if the bucket is silent.
+    qint8 shape;
+    quint8 peak_volume;
+    // How many samples of the bucket have that shape.
+    samplesize shape_length;
+};
+
+// Summaries of a channel's tones at several resolutions, for drawing the
+// tones when many of them fall inside one pixel. Level 0 divides the
+// timeline into buckets of 2^BASE_SHIFT samples, and each level above it
+// merges pairs of buckets from the level below, up to a single bucket.
+// Tones are laid end to end, like ToneRoll lays them out.
+class TonePyramid
+{
+public:
+    static const int BASE_SHIFT = 14;
+
+    void build(const QVector<ToneRow> &rows);
+
+    int level_count() const { return this->levels.size(); }
+    const QVector<ToneSummary> &level(int level) const { return this->levels.at(level); }
+    static samplesize bucket_span(int level) { return samplesize(1) << (BASE_SHIFT + level); }
+    // The coarsest level whose buckets are no wider than max_span samples,
+    // or -1 if even level 0 is wider.
+    int level_for_span(samplesize max_span) const;
+    sampleoff length() const { return this->total_length; }
+
+private:
+    static ToneSummary merge(const ToneSummary &a, const ToneSummary &b);
+
+    QVector<QVector<ToneSummary>> levels;
+    sampleoff total_length = 0;
+};
+
+#endif // TONEPYRAMID_H
@@ -0,0 +1,295 @@
+#include "toneroll.h"
+#include "channelmodel.h"
+
+#include <QColor>
+#include <QMouseEvent>
+#include <QSGGeometryNode>
+#include <QSGVertexColorMaterial>
+
+#include <algorithm>
+#include <cmath>
+
+// Shapes are drawn in enum order, which leaves Irregular and Fixed tones on top.
+const int SHAPE_COUNT = CycleShape::Fixed + 1;
+const int QUAD_VERTICES = 6;
+
+static QColor shape_color(short int shape) {
+    switch (shape) {
+        case CycleShape::SquareEighth:
+            return QColor(0x00, 0xcc, 0x00);
+        case CycleShape::SquareQuarter:
+            return QColor(0x66, 0xcc, 0x00);
+        case CycleShape::SquareHalf:
+            return QColor(0x00, 0xcc, 0x66);
+        case CycleShape::SquareThreeQuarters:
+            return QColor(0x66, 0xcc, 0x66);
+        case CycleShape::Triangle:
+            return QColor(0x00, 0xcc, 0x00);
+        case CycleShape::Irregular:
+            return QColor(0xcc, 0x00, 0x00);
+        case CycleShape::Fixed:
+            return QColor(0xff, 0x99, 0x00);
+    }
+    return QColor(0x00, 0x00, 0x00);
+}
+
+// Writes two triangles covering the quadrilateral top_left, top_right, bottom_right, bottom_left.
+static QSGGeometry::ColoredPoint2D *write_quad(QSGGeometry::ColoredPoint2D *vertex, QPointF top_left, QPointF top_right,
+                                               QPointF bottom_right, QPointF bottom_left, QColor color, qreal opacity) {
+    // The vertex color material expects premultiplied colors.
+    uchar r = color.red() * opacity;
+    uchar g = color.green() * opacity;
+    uchar b = color.blue() * opacity;
+    uchar a = 255 * opacity;
+    const QPointF corners[QUAD_VERTICES] { top_left, top_right, bottom_right, top_left, bottom_right, bottom_left };
+    for (const QPointF &corner: corners) {
+        vertex->set(corner.x(), corner.y(), r, g, b, a);
+        vertex += 1;
+    }
+    return vertex;
+}
+
+// Sizes each shape's geometry for the given number of vertices, and points
+// vertices at the start of each one.
+static void allocate_vertices(QSGNode *root, QSGGeometry::ColoredPoint2D *vertices[], const int vertex_counts[]) {
+    QSGNode *child = root->firstChild();
+    for (int shape = 0; shape < SHAPE_COUNT; shape += 1) {
+        QSGGeometryNode *node = static_cast<QSGGeometryNode*>(child);
+        node->geometry()->allocate(vertex_counts[shape]);
+        vertices[shape] = node->geometry()->vertexDataAsColoredPoint2D();
+        node->markDirty(QSGNode::DirtyGeometry);
+        child = child->nextSibling();
+    }
+}
+
+ToneRoll::ToneRoll(QQuickItem *parent)
+    : QQuickItem(parent)
+{
+    this->setFlag(ItemHasContents, true);
+    this->setAcceptedMouseButtons(Qt::LeftButton);
+    QObject::connect(this, SIGNAL(modelChanged(ChannelModel*)), this, SLOT(attach_model()));
+    QObject::connect(this, SIGNAL(lowestToneChanged(int)), this, SLOT(layout_changed()));
+    QObject::connect(this, SIGNAL(highestToneChanged(int)), this, SLOT(layout_changed()));
+    QObject::connect(this, SIGNAL(paddedHighestToneChanged(int)), this, SLOT(layout_changed()));
+    QObject::connect(this, SIGNAL(noteHeightChanged(qreal)), this, SLOT(layout_changed()));
+    QObject::connect(this, SIGNAL(noteSpacingChanged(qreal)), this, SLOT(layout_changed()));
+    QObject::connect(this, SIGNAL(xScaleChanged(qreal)), this, SLOT(layout_changed()));
+    QObject::connect(this, SIGNAL(heightChanged()), this, SLOT(layout_changed()));
+    QObject::connect(this, SIGNAL(viewportXChanged(qreal)), this, SLOT(viewport_changed()));
+    QObject::connect(this, SIGNAL(viewportWidthChanged(qreal)), this, SLOT(viewport_changed()));
+}
+
+void ToneRoll::attach_model() {
+    if (this->attached_model) {
+        this->attached_model->disconnect(this);
+    }
+    this->attached_model = this->model;
+    if (this->model) {
+        QObject::connect(this->model, SIGNAL(rowsInserted(QModelIndex, int, int)), this, SLOT(rows_changed()));
+        QObject::connect(this->model, SIGNAL(rowsRemoved(QModelIndex, int, int)), this, SLOT(rows_changed()));
+        QObject::connect(this->model, SIGNAL(dataChanged(QModelIndex, QModelIndex, QVector<int>)), this, SLOT(rows_changed()));
+        QObject::connect(this->model, SIGNAL(modelReset()), this, SLOT(rows_changed()));
+    }
+    this->rows_changed();
+}
+
+void ToneRoll::rows_changed() {
+    this->tone_x.clear();
+    sampleoff x = 0;
+    if (this->model) {
+        const QVector<ToneRow> &rows = this->model->rows();
+        this->tone_x.reserve(rows.size());
+        for (const ToneRow &row: rows) {
+            this->tone_x.append(x);
+            x += row.length;
+        }
+    }
+    this->setImplicitWidth(x);
+    this->layout_changed();
+}
+
+void ToneRoll::layout_changed() {
+    this->geometry_dirty = true;
+    this->update();
+}
+
+void ToneRoll::viewport_changed() {
+    if (this->viewport_width < 0 || this->viewport_x < this->drawn_left
+        || this->viewport_x + this->viewport_width > this->drawn_right) {
+        this->layout_changed();
+    }
+}
+
+QRectF ToneRoll::tone_rect(int row, qreal *slope_y) const {
+    const ToneRow &tone = this->model->rows().at(row);
+    bool in_range = this->lowest_tone <= tone.semitone_id && tone.semitone_id <= this->highest_tone
+                    && tone.shape != CycleShape::None;
+    qreal y = in_range ? (this->padded_highest_tone - tone.semitone_id) * this->note_height : 0;
+    qreal height = (tone.semitone_id > -999 && tone.shape != CycleShape::None)
+                   ? this->note_height - this->note_spacing : this->height();
+    if (slope_y) {
+        // How far the bottom edge has moved by the end of a sweeping tone.
+        *slope_y = y ? (this->padded_highest_tone - semitone_id_end(tone.semitone_id, tone.nes_timer_end)) * this->note_height - y : 0;
+    }
+    return QRectF(this->tone_x.at(row), y, tone.length, height);
+}
+
+int ToneRoll::tone_at(const QPointF &point) const {
+    if (!this->model || this->tone_x.isEmpty()) {
+        return -1;
+    }
+    // Zero-length tones share their x with the next tone, which is the one that's visible.
+    auto after = std::upper_bound(this->tone_x.constBegin(), this->tone_x.constEnd(), sampleoff(point.x()));
+    int row = int(after - this->tone_x.constBegin()) - 1;
+    if (row < 0) {
+        return -1;
+    }
+    qreal slope_y;
+    QRectF rect = this->tone_rect(row, &slope_y);
+    if (point.x() >= rect.right()) {
+        return -1;
+    }
+    qreal top = rect.top() + (rect.width() ? slope_y * (point.x() - rect.left()) / rect.width() : 0);
+    if (point.y() < top || point.y() >= top + rect.height()) {
+        return -1;
+    }
+    return row;
+}
+
+void ToneRoll::mousePressEvent(QMouseEvent *event) {
+    // Presses that miss every tone go on to the items underneath.
+    this->pressed_row = this->tone_at(event->localPos());
+    if (this->pressed_row < 0) {
+        event->ignore();
+    }
+}
+
+void ToneRoll::mouseReleaseEvent(QMouseEvent *event) {
+    if (this->pressed_row >= 0 && this->tone_at(event->localPos()) == this->pressed_row) {
+        emit this->toneClicked(this->pressed_row);
+    }
+    this->pressed_row = -1;
+}
+
+QSGNode *ToneRoll::updatePaintNode(QSGNode *old_node, UpdatePaintNodeData *data) {
+    Q_UNUSED(data);
+    QSGNode *root = old_node;
+    if (!root) {
+        root = new QSGNode;
+        for (int shape = 0; shape < SHAPE_COUNT; shape += 1) {
+            QSGGeometryNode *node = new QSGGeometryNode;
+            QSGGeometry *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(), 0);
+            geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+            node->setGeometry(geometry);
+            node->setFlag(QSGNode::OwnsGeometry);
+            node->setMaterial(new QSGVertexColorMaterial);
+            node->setFlag(QSGNode::OwnsMaterial);
+            root->appendChildNode(node);
+        }
+        this->geometry_dirty = true;
+    }
+    if (!this->geometry_dirty) {
+        return root;
+    }
+    this->geometry_dirty = false;
+
+    // Draw a viewport's width either side of the viewport, so scrolling by
+    // less than that keeps the geometry as it is.
+    if (this->viewport_width < 0) {
+        this->drawn_left = 0;
+        this->drawn_right = this->implicitWidth();
+    } else {
+        this->drawn_left = this->viewport_x - this->viewport_width;
+        this->drawn_right = this->viewport_x + 2 * this->viewport_width;
+    }
+    sampleoff left = std::max<sampleoff>(0, std::floor(this->drawn_left));
+    sampleoff right = std::ceil(this->drawn_right);
+
+    // The GUI thread is blocked while this runs, so the model can be read directly.
+    const int row_count = this->model ? this->model->rows().size() : 0;
+    // When tones are narrower than a pixel on average, draw the pyramid
+    // level with about one bucket per pixel instead.
+    int lod_level = -1;
+    if (row_count && this->x_scale < 1) {
+        const TonePyramid &pyramid = this->model->pyramid();
+        lod_level = pyramid.level_for_span(1 / this->x_scale);
+        if (lod_level >= 0 && pyramid.level(lod_level).size() >= row_count) {
+            lod_level = -1;
+        }
+    }
+    if (lod_level >= 0) {
+        this->write_summaries(root, lod_level, left, right);
+    } else {
+        this->write_tones(root, left, right);
+    }
+    return root;
+}
+
+// Writes the tones overlapping samples [left, right).
+void ToneRoll::write_tones(QSGNode *root, sampleoff left, sampleoff right) {
+    const QVector<ToneRow> rows = this->model ? this->model->rows() : QVector<ToneRow> {};
+    // The last tone starting at or before 'left' is the first one overlapping it.
+    int first = int(std::upper_bound(this->tone_x.constBegin(), this->tone_x.constEnd(), left)
+                    - this->tone_x.constBegin()) - 1;
+    first = std::max(first, 0);
+    int last = int(std::lower_bound(this->tone_x.constBegin(), this->tone_x.constEnd(), right)
+                   - this->tone_x.constBegin());
+    QSGGeometry::ColoredPoint2D *vertices[SHAPE_COUNT];
+    int vertex_counts[SHAPE_COUNT] {};
+    for (int row = first; row < last; row += 1) {
+        const ToneRow &tone = rows.at(row);
+        short int shape = qBound<short int>(0, tone.shape, SHAPE_COUNT - 1);
+        // Every tone but silence also gets an onset marker.
+        vertex_counts[shape] += shape == CycleShape::None ? QUAD_VERTICES : 2 * QUAD_VERTICES;
+    }
+    allocate_vertices(root, vertices, vertex_counts);
+    const qreal onset_width = 1 / this->x_scale;
+    for (int row = first; row < last; row += 1) {
+        const ToneRow &tone = rows.at(row);
+        short int shape = qBound<short int>(0, tone.shape, SHAPE_COUNT - 1);
+        QColor color = shape_color(shape);
+        qreal opacity = shape == CycleShape::Irregular ? 1 : (tone.volume + 2) / 17.0;
+        qreal slope_y;
+        QRectF rect = this->tone_rect(row, &slope_y);
+        vertices[shape] = write_quad(vertices[shape], rect.topLeft(), rect.topRight() + QPointF(0, slope_y),
+                                     rect.bottomRight() + QPointF(0, slope_y), rect.bottomLeft(), color, opacity);
+        if (shape != CycleShape::None) {
+            QRectF onset(rect.left(), rect.top(), onset_width, rect.height());
+            vertices[shape] = write_quad(vertices[shape], onset.topLeft(), onset.topRight(),
+                                         onset.bottomRight(), onset.bottomLeft(), color, 1);
+        }
+    }
+}
+
+// Writes the buckets overlapping samples [left, right).
+void ToneRoll::write_summaries(QSGNode *root, int level, sampleoff left, sampleoff right) {
+    const TonePyramid &pyramid = this->model->pyramid();
+    const QVector<ToneSummary> &buckets = pyramid.level(level);
+    const samplesize span = TonePyramid::bucket_span(level);
+    int first = int(left / span);
+    int last = std::min<sampleoff>(buckets.size(), (right + span - 1) / span);
+    QSGGeometry::ColoredPoint2D *vertices[SHAPE_COUNT];
+    int vertex_counts[SHAPE_COUNT] {};
+    for (int bucket_i = first; bucket_i < last; bucket_i += 1) {
+        vertex_counts[buckets.at(bucket_i).shape] += QUAD_VERTICES;
+    }
+    allocate_vertices(root, vertices, vertex_counts);
+    for (int bucket_i = first; bucket_i < last; bucket_i += 1) {
+        const ToneSummary &bucket = buckets.at(bucket_i);
+        sampleoff left = bucket_i * span;
+        sampleoff right = std::min(left + span, pyramid.length());
+        QRectF rect;
+        if (bucket.shape == CycleShape::None) {
+            rect = QRectF(left, 0, right - left, this->height());
+        } else {
+            // One band from the highest to the lowest semitone, kept on the keyboard.
+            qreal top = qBound<qreal>(this->lowest_tone, bucket.max_semitone, this->highest_tone);
+            qreal bottom = qBound<qreal>(this->lowest_tone, bucket.min_semitone, this->highest_tone);
+            rect = QRectF(left, (this->padded_highest_tone - top) * this->note_height,
+                          right - left, (top - bottom + 1) * this->note_height - this->note_spacing);
+        }
+        qreal opacity = bucket.shape == CycleShape::Irregular ? 1 : (bucket.peak_volume + 2) / 17.0;
+        vertices[bucket.shape] = write_quad(vertices[bucket.shape], rect.topLeft(), rect.topRight(),
+                                            rect.bottomRight(), rect.bottomLeft(), shape_color(bucket.shape), opacity);
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef TONEROLL_H
+#define TONEROLL_H
+
+#include <QPointer>
+#include <QQuickItem>
+#include <QVector>
+
+#include "toneobject.h"
+
+class ChannelModel;
+
+// Draws a channel's tones as a piano roll straight from its ChannelModel.
+// Every tone of one shape goes into the same geometry node, so the scene
+// graph draws each shape in one batch however many tones there are.
+// Across, the item is measured in samples, like the tones' lengths; zooming
+// is left to a transform on a parent item. Only the tones around the viewport
+// are drawn, so the geometry stays the same size however long the track is.
+class ToneRoll : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(ChannelModel *model MEMBER model NOTIFY modelChanged)
+    Q_PROPERTY(int lowestTone MEMBER lowest_tone NOTIFY lowestToneChanged)
+    Q_PROPERTY(int highestTone MEMBER highest_tone NOTIFY highestToneChanged)
+    Q_PROPERTY(int paddedHighestTone MEMBER padded_highest_tone NOTIFY paddedHighestToneChanged)
+    Q_PROPERTY(qreal noteHeight MEMBER note_height NOTIFY noteHeightChanged)
+    Q_PROPERTY(qreal noteSpacing MEMBER note_spacing NOTIFY noteSpacingChanged)
+    // Samples are shown this many pixels wide. Tone onsets are kept one pixel wide.
+    Q_PROPERTY(qreal xScale MEMBER x_scale NOTIFY xScaleChanged)
+    // The part of the item that's on screen, in samples. Only the tones near it
+    // are drawn. A negative width draws every tone.
+    Q_PROPERTY(qreal viewportX MEMBER viewport_x NOTIFY viewportXChanged)
+    Q_PROPERTY(qreal viewportWidth MEMBER viewport_width NOTIFY viewportWidthChanged)
+
+public:
+    explicit ToneRoll(QQuickItem *parent = nullptr);
+
+    // The row of the tone drawn at 'point', or -1 if there isn't one.
+    Q_INVOKABLE int tone_at(const QPointF &point) const;
+
+signals:
+    void modelChanged(ChannelModel *model);
+    void lowestToneChanged(int lowest_tone);
+    void highestToneChanged(int highest_tone);
+    void paddedHighestToneChanged(int padded_highest_tone);
+    void noteHeightChanged(qreal note_height);
+    void noteSpacingChanged(qreal note_spacing);
+    void xScaleChanged(qreal x_scale);
+    void viewportXChanged(qreal viewport_x);
+    void viewportWidthChanged(qreal viewport_width);
+    void toneClicked(int row);
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *old_node, UpdatePaintNodeData *data) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+private slots:
+    void attach_model();
+    void rows_changed();
+    void layout_changed();
+    void viewport_changed();
+
+private:
+    QRectF tone_rect(int row, qreal *slope_y = nullptr) const;
+    void write_tones(QSGNode *root, sampleoff left, sampleoff right);
+    void write_summaries(QSGNode *root, int level, sampleoff left, sampleoff right);
+
+    ChannelModel *model = nullptr;
+    QPointer<ChannelModel> attached_model;
+    int lowest_tone = 0;
+    int highest_tone = 0;
+    int padded_highest_tone = 0;
+    qreal note_height = 0;
+    qreal note_spacing = 0;
+    qreal x_scale = 1;
+    qreal viewport_x = 0;
+    qreal viewport_width = -1;
+
+    // Where each tone starts across. Tones are laid end to end, like items in a Row.
+    QVector<sampleoff> tone_x;
+    bool geometry_dirty = true;
+    // The span the geometry was last written for. Scrolling within it doesn't
+    // need new geometry.
+    qreal drawn_left = 0;
+    qreal drawn_right = 0;
+    int pressed_row = -1;
+};
+
+#endif // TONEROLL_H
@@ -8,16 +8,19 @@ TriangleChannel::TriangleChannel()
 
 }
 
-QVector<Cycle> TriangleChannel::runs_to_cycles(QList<Run> &runs) {
+QVector<Cycle> TriangleChannel::runs_to_cycles(const RunBuffer &runs) {
     const samplesize LONGEST_CYCLE = 32768;
     QVector<Cycle> cycles;
     if (runs.size() == 0) return cycles;
-    const Cycle clear_cycle = { 0, CycleShape::Irregular, -999, -999, {} };
+    const Cycle clear_cycle = { 0, CycleShape::Irregular, -999, -999, 0, 0, 0 };
+    this->original_runs = runs;
     Cycle cycle = clear_cycle;
-    cycle.start = runs[0].start;
-    cycle.runs.append(runs[0]);
-    bool tip = (runs[0].value == 0 || runs[0].value == 15);
-    samplesize period = (tip ? 16 : 32) * runs[0].length;
+    RunBuffer::const_iterator run_i = runs.begin();
+    cycle.start = run_i->start;
+    cycle.first_run = run_i.index();
+    add_run(cycle, *run_i);
+    bool tip = (run_i->value == 0 || run_i->value == 15);
+    samplesize period = (tip ? 16 : 32) * run_i->length;
     if (period <= LONGEST_CYCLE) {
         cycle.shape = CycleShape::Triangle;
         cycle.semitone_id = period_to_semitone(period);
@@ -28,20 +31,22 @@ QVector<Cycle> TriangleChannel::runs_to_cycles(QList<Run> &runs) {
     bool prev_tip = tip;
     samplesize prev_period = period;
     bool prev_rising = rising;
-    for (int i=1; i < runs.size(); i += 1) {
-        tip = (runs[i].value == 0 || runs[i].value == 15);
-        period = (tip ? 16 : 32) * runs[i].length;
-        rising = (runs[i].value > runs[i-1].value);
+    samplevalue prev_value = run_i->value;
+    for (++run_i; run_i != runs.end(); ++run_i) {
+        tip = (run_i->value == 0 || run_i->value == 15);
+        period = (tip ? 16 : 32) * run_i->length;
+        rising = (run_i->value > prev_value);
         bool changed_direction = (rising != prev_rising && !prev_tip);
         bool changed_period = period != prev_period;
-        bool completed_cycle = cycle.runs.size() == 30;
+        bool completed_cycle = cycle.run_count == 30;
         if (changed_direction || changed_period || completed_cycle) {
-            //qDebug() << cycle.start << cycle.shape << cycle.semitone_id << cycle.runs.count() << sum_run_lengths(cycle);
+            //qDebug() << cycle.start << cycle.shape << cycle.semitone_id << cycle.run_count << sum_run_lengths(cycle);
             cycles.append(cycle);
             cycle = clear_cycle;
-            cycle.start = runs[i].start;
+            cycle.start = run_i->start;
+            cycle.first_run = run_i.index();
         }
-        cycle.runs.append(runs[i]);
+        add_run(cycle, *run_i);
         if (period <= LONGEST_CYCLE) {
             cycle.shape = CycleShape::Triangle;
             cycle.semitone_id = period_to_semitone(period);
@@ -51,8 +56,9 @@ QVector<Cycle> TriangleChannel::runs_to_cycles(QList<Run> &runs) {
         prev_tip = tip;
         prev_period = period;
         prev_rising = rising;
+        prev_value = run_i->value;
     }
-    //qDebug() << cycle.start << cycle.shape << cycle.semitone_id << cycle.runs.count() << sum_run_lengths(cycle);
+    //qDebug() << cycle.start << cycle.shape << cycle.semitone_id << cycle.run_count << sum_run_lengths(cycle);
     cycles.append(cycle);
     qDebug() << "Cycle count: " << cycles.size();
     return cycles;
@@ -3,7 +3,8 @@
 
 #include <QList>
 
-struct Run;
+#include "runbuffer.h"
+
 struct Cycle;
 class ToneObject;
 
@@ -12,11 +13,12 @@ class TriangleChannel
 public:
     TriangleChannel();
 
-    QVector<Cycle> runs_to_cycles(QList<Run> &runs);
+    QVector<Cycle> runs_to_cycles(const RunBuffer &runs);
     QVector<ToneObject> find_tones(QVector<Cycle> &cycles);
 
 private:
-    QList<Run> original_runs;
+    // The runs that the cycles refer to.
+    RunBuffer original_runs;
     QList<ToneObject> tones;
 };
 
@@ -0,0 +1,103 @@
+#include "wavanalysis.h"
+#include "archiveblockreader.h"
+#include "runscanner.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <cstring>
+
+#include <archive.h>
+#include <archive_entry.h>
+
+const std::streamsize READ_BLOCK_SIZE = 1 << 20;
+const int READ_BLOCK_COUNT = 4; // Decompression can run this many blocks ahead of the scan.
+
+QString WavAnalysis::analyse(const QString &file_name) {
+    QString error = this->read_runs(file_name);
+    if (error.isEmpty()) {
+        this->find_tones();
+    }
+    return error;
+}
+
+QString WavAnalysis::read_runs(const QString &file_name) {
+    const int CHANNELS = RunScanner::CHANNELS;
+    struct archive *archive = archive_read_new();
+    archive_read_support_filter_gzip(archive);
+    archive_read_support_filter_xz(archive);
+    archive_read_support_format_raw(archive);
+    struct archive_entry *entry;
+    WAVheader header;
+    QString error;
+    if (archive_read_open_filename(archive, qPrintable(file_name), 1048576) != ARCHIVE_OK
+            || archive_read_next_header(archive, &entry) != ARCHIVE_OK) {
+        error = archive_error_string(archive);
+    } else if (archive_read_data(archive, &header, sizeof(header)) != sizeof(header)
+               || header.audio_format != 1 || header.num_channels != CHANNELS
+               || header.sample_rate != 1789773 || header.bits_per_sample != 8) {
+        error = "Not an 8-bit capture of the five APU channels";
+    }
+    if (!error.isEmpty()) {
+        archive_read_free(archive);
+        return file_name + ": " + error;
+    }
+
+    RunScanner scanner;
+    QElapsedTimer load_timer;
+    QElapsedTimer scan_timer;
+    qint64 scan_nsecs = 0;
+    load_timer.start();
+    {
+        // Each block has room in front for a partial frame carried over from the previous one.
+        ArchiveBlockReader reader(archive, READ_BLOCK_SIZE, READ_BLOCK_COUNT, CHANNELS);
+        char carry[CHANNELS];
+        std::streamsize carried = 0;
+        char *data;
+        std::streamsize bytes_read = reader.next_block(data);
+        if (bytes_read == 0) {
+            error = "The capture has no samples";
+        }
+        while (bytes_read) {
+            data -= carried;
+            memcpy(data, carry, carried);
+            std::streamsize available = carried + bytes_read;
+            sampleoff frame_count = available / CHANNELS;
+            scan_timer.start();
+            scanner.scan(reinterpret_cast<samplevalue*>(data), frame_count);
+            scan_nsecs += scan_timer.nsecsElapsed();
+            carried = available - frame_count * CHANNELS;
+            memcpy(carry, data + frame_count * CHANNELS, carried);
+            bytes_read = reader.next_block(data);
+        }
+    }
+    archive_read_free(archive);
+    if (!error.isEmpty()) {
+        return file_name + ": " + error;
+    }
+    this->channel_runs = scanner.finish();
+    for (int channel_i = 0; channel_i < CHANNELS; channel_i += 1) {
+        qDebug() << "Channel" << channel_i << "run count:" << this->channel_runs[channel_i].size()
+                 << "in" << this->channel_runs[channel_i].packed_size() << "bytes";
+    }
+    qint64 bytes_scanned = scanner.frames_scanned() * CHANNELS;
+    qDebug() << "Scanned" << bytes_scanned << "bytes with"
+             << RunScanner::implementation_name(scanner.implementation()) << "at"
+             << qint64(bytes_scanned * 1e9 / qMax(scan_nsecs, qint64(1))) << "bytes/sec";
+    qDebug() << "Decompressed and scanned in" << load_timer.elapsed() << "ms";
+    return QString();
+}
+
+void WavAnalysis::find_tones() {
+    for (int channel_i = 0; channel_i < 2; channel_i += 1) {
+        SquareChannel &square_channel = this->square_channels[channel_i];
+        QVector<Cycle> cycles = square_channel.runs_to_cycles(this->channel_runs[channel_i]);
+        QVector<ToneObject> tones { square_channel.find_tones(cycles) };
+        square_channel.fix_transitional_tones(tones);
+        square_channel.fix_trailing_tones(tones);
+        square_channel.fix_leading_tones(tones);
+        this->tones[channel_i] = tones;
+    }
+    QVector<Cycle> cycles = this->triangle_channel.runs_to_cycles(this->channel_runs[2]);
+    this->tones[2] = this->triangle_channel.find_tones(cycles);
+}
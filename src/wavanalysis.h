@@ -0,0 +1,49 @@
+#ifndef WAVANALYSIS_H
+#define WAVANALYSIS_H
+
+#include <QString>
+#include <QVector>
+
+#include "runbuffer.h"
+#include "squarechannel.h"
+#include "toneobject.h"
+#include "trianglechannel.h"
+
+struct WAVheader {
+    char RIFF_literal[4];
+    uint32_t chunk_size;
+    char WAVE_literal[4];
+    char fmt__literal[4];
+    uint32_t subchunk1_size;
+    uint16_t audio_format;
+    uint16_t num_channels;
+    uint32_t sample_rate;
+    uint32_t byte_rate;
+    uint16_t block_align;
+    uint16_t bits_per_sample;
+    char data_literal[4];
+    uint32_t subchunk2_size;
+};
+
+// Finds the tones in a capture of the APU: a WAV file, compressed with gzip
+// or xz, holding an 8-bit sample of each of the five channels every CPU
+// cycle. Needs nothing from the GUI, so the command-line analyser uses it too.
+class WavAnalysis
+{
+public:
+    // Returns an error message, or an empty string once the tones are found.
+    QString analyse(const QString &file_name);
+
+    QVector<RunBuffer> channel_runs;
+    // Squares 1 and 2, then the triangle.
+    QVector<ToneObject> tones[3];
+
+private:
+    QString read_runs(const QString &file_name);
+    void find_tones();
+
+    SquareChannel square_channels[2];
+    TriangleChannel triangle_channel;
+};
+
+#endif // WAVANALYSIS_H
@@ -0,0 +1,25 @@
+TEMPLATE = app
+TARGET = tst_squarechannel
+
+QT -= gui
+QT += testlib
+
+CONFIG += c++11
+CONFIG += console
+CONFIG += testcase
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += $$PWD/../src
+
+SOURCES += \
+        ../src/runbuffer.cpp \
+        ../src/squarechannel.cpp \
+        ../src/toneobject.cpp \
+        tst_squarechannel.cpp
+
+HEADERS += \
+    ../src/runbuffer.h \
+    ../src/squarechannel.h \
+    ../src/toneobject.h
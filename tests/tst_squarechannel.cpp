@@ -0,0 +1,206 @@
+#include <QFile>
+#include <QtTest>
+
+#include "runbuffer.h"
+#include "squarechannel.h"
+#include "toneobject.h"
+
+// The square fix-up passes as they were before they were rebuilt as linear
+// copies. They split tones in place, and are kept as the reference the
+// current passes have to match.
+namespace reference {
+
+bool tone_is_square(const ToneObject &tone) {
+    return (
+        tone.shape == CycleShape::SquareEighth ||
+        tone.shape == CycleShape::SquareQuarter ||
+        tone.shape == CycleShape::SquareHalf ||
+        tone.shape == CycleShape::SquareThreeQuarters
+    );
+}
+
+void fix_transitional_tones(QVector<ToneObject> &tones) {
+    double a, b, c;
+    double midpoint;
+    samplesize left_size;
+    ToneObject left, right;
+    for (int i = 1; (i+1) < tones.size(); ) {
+        if (!tone_is_square(tones[i-1]) || tone_is_square(tones[i]) || !tone_is_square(tones[i+1])) {
+            i += 1;
+            continue;
+        }
+        a = tones[i-1].semitone_id;
+        b = tones[i].semitone_id;
+        c = tones[i+1].semitone_id;
+        if (a < b && b < c) {
+            midpoint = (c - b) / (c - a);
+        } else if (a > b && b > c) {
+            midpoint = (b - c) / (a - c);
+        } else {
+            i += 1;
+            continue;
+        }
+        left_size = sum_run_lengths(tones[i-1].cycles.last()) * midpoint;
+        left.semitone_id = tones[i-1].semitone_id;
+        left.shape = CycleShape::Fixed;
+        left.length = left_size;
+        right.semitone_id = tones[i+1].semitone_id;
+        right.shape = CycleShape::Fixed;
+        right.length = tones[i].length - left_size;
+        tones.removeAt(i);
+        tones.insert(i, left);
+        i += 1;
+        tones.insert(i, right);
+        i += 1;
+    }
+}
+
+void fix_trailing_tones(QVector<ToneObject> &tones, const RunBuffer &runs) {
+    ToneObject left, right;
+    for (int i = 1; i < tones.size(); ) {
+        if (!tone_is_square(tones[i-1]) || tone_is_square(tones[i]) || tones[i].shape == CycleShape::Fixed) {
+            i += 1;
+            continue;
+        }
+        samplesize left_size = tones[i-1].match_after(tones[i], runs);
+        left.semitone_id = tones[i-1].semitone_id;
+        left.shape = tones[i-1].shape;
+        left.length = left_size;
+        right.semitone_id = -999;
+        right.shape = CycleShape::None;
+        right.length = tones[i].length - left_size;
+        tones.removeAt(i);
+        if (left.length) {
+            tones.insert(i, left);
+            i += 1;
+        }
+        if (right.length) {
+            tones.insert(i, right);
+            i += 1;
+        }
+    }
+}
+
+void fix_leading_tones(QVector<ToneObject> &tones, const RunBuffer &runs) {
+    ToneObject left, right;
+    for (int i = 0; (i+1) < tones.size(); ) {
+        if (tones[i].shape != CycleShape::Irregular || !tone_is_square(tones[i+1])) {
+            i += 1;
+            continue;
+        }
+        samplesize right_size = tones[i+1].match_before(tones[i], runs);
+        left.semitone_id = tones[i+1].semitone_id;
+        left.shape = CycleShape::Irregular;
+        left.length = tones[i].length - right_size;
+        right.semitone_id = tones[i+1].semitone_id;
+        right.shape = CycleShape::Fixed;
+        right.length = right_size;
+        tones.removeAt(i);
+        if (left.length) {
+            tones.insert(i, left);
+            i += 1;
+        }
+        if (right.length) {
+            tones.insert(i, right);
+            i += 1;
+        }
+    }
+}
+
+}
+
+class TestSquareChannel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void fix_passes_match_reference();
+
+private:
+    static RunBuffer load_runs(int channel_i);
+    static void compare_tones(const QVector<ToneObject> &actual, const QVector<ToneObject> &expected);
+};
+
+// data/square_runs.txt holds both square channels of a short tune, one APU
+// cycle per sample, as "channel N" followed by a "length value" line per run.
+RunBuffer TestSquareChannel::load_runs(int channel_i) {
+    QFile file(QFINDTESTDATA("data/square_runs.txt"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return RunBuffer();
+    }
+    RunBuffer runs;
+    int file_channel_i = -1;
+    sampleoff start = 0;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        QList<QByteArray> fields = line.split(' ');
+        if (fields[0] == "channel") {
+            file_channel_i = fields[1].toInt();
+        } else if (file_channel_i == channel_i) {
+            samplesize length = fields[0].toLong();
+            runs.append({ start, length, samplevalue(fields[1].toInt()) });
+            start += length;
+        }
+    }
+    return runs;
+}
+
+void TestSquareChannel::compare_tones(const QVector<ToneObject> &actual, const QVector<ToneObject> &expected) {
+    QCOMPARE(actual.size(), expected.size());
+    for (int i = 0; i < actual.size(); i += 1) {
+        const ToneObject &a = actual[i];
+        const ToneObject &e = expected[i];
+        QCOMPARE(a.semitone_id, e.semitone_id);
+        QCOMPARE(a.nes_timer, e.nes_timer);
+        QCOMPARE(a.nes_timer_end, e.nes_timer_end);
+        QCOMPARE(a.shape, e.shape);
+        QCOMPARE(a.start, e.start);
+        QCOMPARE(a.length, e.length);
+        QCOMPARE(a.volume, e.volume);
+        QCOMPARE(a.cycles.size(), e.cycles.size());
+        for (int cycle_i = 0; cycle_i < a.cycles.size(); cycle_i += 1) {
+            QCOMPARE(a.cycles[cycle_i].first_run, e.cycles[cycle_i].first_run);
+            QCOMPARE(a.cycles[cycle_i].run_count, e.cycles[cycle_i].run_count);
+        }
+    }
+}
+
+void TestSquareChannel::fix_passes_match_reference() {
+    for (int channel_i = 0; channel_i < 2; channel_i += 1) {
+        RunBuffer runs = load_runs(channel_i);
+        QVERIFY(!runs.isEmpty());
+        SquareChannel square_channel;
+        QVector<Cycle> cycles = square_channel.runs_to_cycles(runs);
+        QVector<ToneObject> tones = square_channel.find_tones(cycles);
+        QVector<ToneObject> expected = tones;
+        int found_count = tones.size();
+
+        square_channel.fix_transitional_tones(tones);
+        reference::fix_transitional_tones(expected);
+        compare_tones(tones, expected);
+        if (QTest::currentTestFailed()) {
+            return;
+        }
+        square_channel.fix_trailing_tones(tones);
+        reference::fix_trailing_tones(expected, runs);
+        compare_tones(tones, expected);
+        if (QTest::currentTestFailed()) {
+            return;
+        }
+        square_channel.fix_leading_tones(tones);
+        reference::fix_leading_tones(expected, runs);
+        compare_tones(tones, expected);
+        if (QTest::currentTestFailed()) {
+            return;
+        }
+        // Otherwise the data doesn't exercise the passes at all.
+        QVERIFY(tones.size() != found_count);
+    }
+}
+
+QTEST_APPLESS_MAIN(TestSquareChannel)
+
+#include "tst_squarechannel.moc"